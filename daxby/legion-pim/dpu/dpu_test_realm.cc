@@ -28,6 +28,9 @@ extern "C" {
 #include <common.h>
 
 #define BLOCK_SIZE 32
+// AOS instances interleave X, Y and Z in one daxpy_t record, a block of
+// records plus the 8 byte alignment slack at both ends
+#define RECORD_WINDOW (BLOCK_SIZE * 3 * sizeof(TYPE) + 16)
 
 typedef struct __DPU_LAUNCH_ARGS {
   char paddd[256];
@@ -37,16 +40,257 @@ __host __DPU_LAUNCH_ARGS ARGS;
 
 DPU_LAUNCH_ARGS *args = (DPU_LAUNCH_ARGS *)(&ARGS);
 
-int main_kernel1();
+int main_init();
+int main_daxpy();
+int main_dot();
+int main_norm();
 
 // Barrier
 BARRIER_INIT(my_barrier, NR_TASKLETS);
 
-int (*kernels[nr_kernels])(void) = {main_kernel1};
+// per tasklet partial sums for the dot and norm kernels
+ACC_TYPE partial[NR_TASKLETS];
+__dma_aligned ACC_TYPE result;
 
-int main(void) { return kernels[args->kernel](); }
+int (*kernels[nr_kernels])(void) = {main_init, main_daxpy, main_dot,
+                                    main_norm};
 
-int main_kernel1() {
+int main(void) {
+  // the program stays loaded between launches, so the heap left behind by
+  // the previous kernel has to be released before this one allocates
+  if (me() == 0)
+    mem_reset();
+  barrier_wait(&my_barrier);
+  return kernels[args->kernel]();
+}
+
+// number of elements left in the block starting at point, capped at BLOCK_SIZE
+static inline unsigned int block_elements(Point<1> point, Rect<1> rect) {
+  coord_t remaining = rect.hi.value - point.value + 1;
+  return remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+}
+
+// SOA instances are dense, anything wider is an interleaved AOS instance
+static inline bool is_aos(const Point<1> &strides) {
+  return strides[0] != sizeof(TYPE);
+}
+
+// MRAM transfers must start and end on 8 byte boundaries, so an AOS block is
+// moved as the aligned window [lo, lo + bytes) around its records
+static inline uintptr_t window_lo(uintptr_t first) {
+  return first & ~(uintptr_t)7;
+}
+
+static inline uint32_t window_bytes(uintptr_t lo, uintptr_t last) {
+  return (last + sizeof(TYPE) - lo + 7) & ~7;
+}
+
+// gather one field of `elements` AOS records starting at first into dst
+static void load_aos(uintptr_t first, uint32_t stride, unsigned int elements,
+                     uint8_t *records, TYPE *dst) {
+  uintptr_t lo = window_lo(first);
+  mram_read((const __mram_ptr void *)lo, records,
+            window_bytes(lo, first + (elements - 1) * stride));
+  uint8_t *field = records + (first - lo);
+  for (unsigned int i = 0; i < elements; i++)
+    dst[i] = *(TYPE *)(field + i * stride);
+}
+
+// scatter src into one field of `elements` AOS records, the other fields of
+// the records are read first so they are written back unchanged
+static void store_aos(uintptr_t first, uint32_t stride, unsigned int elements,
+                      uint8_t *records, const TYPE *src) {
+  uintptr_t lo = window_lo(first);
+  uint32_t bytes = window_bytes(lo, first + (elements - 1) * stride);
+  mram_read((const __mram_ptr void *)lo, records, bytes);
+  uint8_t *field = records + (first - lo);
+  for (unsigned int i = 0; i < elements; i++)
+    *(TYPE *)(field + i * stride) = src[i];
+  mram_write(records, (__mram_ptr void *)lo, bytes);
+}
+
+// xorshift32 over (seed, index) so every element is reproducible
+// independently of how the rect is split across tasklets; the host picks
+// a well mixed seed so no multiply is needed here
+static inline uint32_t dpu_random(uint32_t seed, uint32_t index) {
+  uint32_t x = seed ^ index;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+int main_init() {
+  unsigned int tasklet_id = me();
+
+#ifdef PRINT_UPMEM
+  if (tasklet_id == 0) {
+    printf("DEVICE:::: Running init with seed %u, ptr %p\n", args->seed,
+           args->acc_z.ptr(args->rect.lo));
+  }
+#endif
+
+  Rect<1> rect;
+  rect.lo = args->rect.lo + tasklet_id * BLOCK_SIZE;
+  rect.hi = args->rect.hi;
+
+  const bool aos = is_aos(args->acc_z.accessor.strides);
+  uint8_t *records = aos ? (uint8_t *)mem_alloc(RECORD_WINDOW) : NULL;
+
+  AccessorWD block_acc_z;
+  block_acc_z.accessor.base = (uintptr_t)mem_alloc(BLOCK_SIZE * sizeof(TYPE));
+  block_acc_z.accessor.strides = Point<1>(sizeof(TYPE));
+
+  for (Legion::PointInRectIterator<1> pir(rect); pir();
+       pir += (NR_TASKLETS * BLOCK_SIZE)) {
+    unsigned int elements = block_elements(*pir, rect);
+
+    Rect<1> block_rect;
+    block_rect.lo = 0;
+    block_rect.hi = elements - 1;
+
+    for (Legion::PointInRectIterator<1> pir_block(block_rect); pir_block();
+         pir_block++) {
+      uint32_t r = dpu_random(args->seed,
+                              (*pir).value + (*pir_block).value);
+      block_acc_z.write(*pir_block, RANDOM_VALUE(r));
+    }
+
+    if (aos) {
+      store_aos((uintptr_t)args->acc_z.ptr(*pir),
+                args->acc_z.accessor.strides[0], elements, records,
+                (TYPE *)block_acc_z.accessor.base);
+      continue;
+    }
+    // the host keeps every sub-region a whole number of 8 byte words, so
+    // the last block ends on rect.hi without rounding
+    WRITE_BLOCK(*pir, args->acc_z, block_acc_z, elements * sizeof(TYPE));
+  }
+  return 0;
+}
+
+// shared body of the dot and norm kernels, norm reuses acc_x for both operands
+static int reduce_kernel(bool square) {
+  unsigned int tasklet_id = me();
+
+  Rect<1> rect;
+  rect.lo = args->rect.lo + tasklet_id * BLOCK_SIZE;
+  rect.hi = args->rect.hi;
+
+  const bool aos = is_aos(args->acc_x.accessor.strides);
+  uint8_t *records = aos ? (uint8_t *)mem_alloc(RECORD_WINDOW) : NULL;
+
+  // block accessors index dense WRAM copies whatever the MRAM layout is
+  AccessorRO block_acc_x;
+  AccessorRO block_acc_y;
+  block_acc_x.accessor.base = (uintptr_t)mem_alloc(BLOCK_SIZE * sizeof(TYPE));
+  block_acc_x.accessor.strides = Point<1>(sizeof(TYPE));
+  if (!square) {
+    block_acc_y.accessor.base =
+        (uintptr_t)mem_alloc(BLOCK_SIZE * sizeof(TYPE));
+    block_acc_y.accessor.strides = Point<1>(sizeof(TYPE));
+  }
+
+  ACC_TYPE sum = 0;
+  for (Legion::PointInRectIterator<1> pir(rect); pir();
+       pir += (NR_TASKLETS * BLOCK_SIZE)) {
+    unsigned int elements = block_elements(*pir, rect);
+
+    if (aos) {
+      load_aos((uintptr_t)args->acc_x.ptr(*pir),
+               args->acc_x.accessor.strides[0], elements, records,
+               (TYPE *)block_acc_x.accessor.base);
+      if (!square)
+        load_aos((uintptr_t)args->acc_y.ptr(*pir),
+                 args->acc_y.accessor.strides[0], elements, records,
+                 (TYPE *)block_acc_y.accessor.base);
+    } else {
+      READ_BLOCK(*pir, args->acc_x, block_acc_x, BLOCK_SIZE * sizeof(TYPE));
+      if (!square)
+        READ_BLOCK(*pir, args->acc_y, block_acc_y, BLOCK_SIZE * sizeof(TYPE));
+    }
+
+    Rect<1> block_rect;
+    block_rect.lo = 0;
+    block_rect.hi = elements - 1;
+
+    for (Legion::PointInRectIterator<1> pir_block(block_rect); pir_block();
+         pir_block++) {
+      ACC_TYPE x = block_acc_x[*pir_block];
+      sum += x * (square ? x : (ACC_TYPE)block_acc_y[*pir_block]);
+    }
+  }
+  partial[tasklet_id] = sum;
+
+  barrier_wait(&my_barrier);
+
+  if (tasklet_id == 0) {
+    result = 0;
+    for (unsigned int i = 0; i < NR_TASKLETS; i++)
+      result += partial[i];
+
+    AccessorWDacc block_acc_out;
+    block_acc_out.accessor.base = (uintptr_t)&result;
+    block_acc_out.accessor.strides = args->acc_out.accessor.strides;
+    WRITE_BLOCK(args->out, args->acc_out, block_acc_out, sizeof(ACC_TYPE));
+  }
+  return 0;
+}
+
+int main_dot() { return reduce_kernel(false); }
+
+int main_norm() { return reduce_kernel(true); }
+
+// daxpy over AOS instances: X and Y of an element sit in the same daxpy_t
+// record, so a block of records is DMA'd once and both fields are
+// deinterleaved in WRAM; Z is updated in place in its own records
+static int daxpy_aos(Rect<1> rect) {
+  const uint32_t stride_x = args->acc_x.accessor.strides[0];
+  const uint32_t stride_y = args->acc_y.accessor.strides[0];
+  const uint32_t stride_z = args->acc_z.accessor.strides[0];
+
+  uint8_t *in_records = (uint8_t *)mem_alloc(RECORD_WINDOW);
+  uint8_t *out_records = (uint8_t *)mem_alloc(RECORD_WINDOW);
+  TYPE *x = (TYPE *)mem_alloc(BLOCK_SIZE * sizeof(TYPE));
+  TYPE *y = (TYPE *)mem_alloc(BLOCK_SIZE * sizeof(TYPE));
+
+  for (Legion::PointInRectIterator<1> pir(rect); pir();
+       pir += (NR_TASKLETS * BLOCK_SIZE)) {
+    unsigned int elements = block_elements(*pir, rect);
+    uintptr_t ptr_x = (uintptr_t)args->acc_x.ptr(*pir);
+    uintptr_t ptr_y = (uintptr_t)args->acc_y.ptr(*pir);
+    uintptr_t ptr_z = (uintptr_t)args->acc_z.ptr(*pir);
+
+    uintptr_t first = ptr_x < ptr_y ? ptr_x : ptr_y;
+    uintptr_t last = ptr_x < ptr_y ? ptr_y : ptr_x;
+    if ((stride_x == stride_y) && (last - first < stride_x)) {
+      uintptr_t lo = window_lo(first);
+      mram_read((const __mram_ptr void *)lo, in_records,
+                window_bytes(lo, last + (elements - 1) * stride_x));
+      uint8_t *field_x = in_records + (ptr_x - lo);
+      uint8_t *field_y = in_records + (ptr_y - lo);
+      for (unsigned int i = 0; i < elements; i++) {
+        x[i] = *(TYPE *)(field_x + i * stride_x);
+        y[i] = *(TYPE *)(field_y + i * stride_x);
+      }
+    } else {
+      // X and Y were mapped to different instances
+      load_aos(ptr_x, stride_x, elements, in_records, x);
+      load_aos(ptr_y, stride_y, elements, in_records, y);
+    }
+
+    for (unsigned int i = 0; i < elements; i++)
+      x[i] = TYPE_MUL(args->alpha, x[i]) + y[i];
+
+    store_aos(ptr_z, stride_z, elements, out_records, x);
+  }
+  return 0;
+}
+
+int main_daxpy() {
   unsigned int tasklet_id = me();
 
 #ifdef PRINT_UPMEM
@@ -58,10 +302,10 @@ int main_kernel1() {
 
     printf("DEVICE::: my tasklet id is %d, the lower bound of the rect is %d \n", tasklet_id, args->rect.lo.value);
 
-#ifdef INT32
-    printf(" alpha = %d \n", args->alpha);
-#elif DOUBLE
-    printf(" alpha = %f \n", args->alpha);
+#if defined(TYPE_IS_FLOAT)
+    printf(" alpha = %f \n", (double)args->alpha);
+#else
+    printf(" alpha = %lld \n", (long long)args->alpha);
 #endif
   }
 #endif
@@ -71,6 +315,10 @@ int main_kernel1() {
   rect.lo = args->rect.lo + tasklet_id * BLOCK_SIZE;
   rect.hi = args->rect.hi;
 
+  if (is_aos(args->acc_x.accessor.strides) ||
+      is_aos(args->acc_z.accessor.strides))
+    return daxpy_aos(rect);
+
   AccessorRO block_acc_y;
   AccessorRO block_acc_x;
   AccessorWD block_acc_z;
@@ -121,8 +369,9 @@ int main_kernel1() {
     // block iterator
     for (Legion::PointInRectIterator<1> pir_block(block_rect); pir_block();
          pir_block++) {
-      block_acc_z.write(*pir_block, args->alpha * block_acc_x[*pir_block] +
-                                        block_acc_y[*pir_block]);
+      block_acc_z.write(*pir_block,
+                        TYPE_MUL(args->alpha, block_acc_x[*pir_block]) +
+                            block_acc_y[*pir_block]);
     }
 
     // write block
@@ -0,0 +1,164 @@
+/* Copyright 2024 Stanford University, Los Alamos National Laboratory,
+ *                Northwestern University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "daxby_mapper.h"
+
+Logger log_mapper("mapper");
+
+DaxbyMapper::DaxbyMapper(MapperRuntime *rt, Machine machine, Processor local,
+                         const char *mapper_name,
+                         std::map<Processor, Memory>* _proc_mrams)
+  : DefaultMapper(rt, machine, local, mapper_name),
+    proc_mrams(*_proc_mrams)
+{
+}
+
+void DaxbyMapper::map_task(const MapperContext      ctx,
+                           const Task&              task,
+                           const MapTaskInput&      input,
+                                 MapTaskOutput&     output)
+{
+  std::map<Processor, Memory>::const_iterator finder =
+    proc_mrams.find(task.target_proc);
+  // only DPU tasks with regions are pinned, everything else (the top level
+  // task and the CPU init/check tasks) keeps the default policy
+  if (task.regions.empty() || (finder == proc_mrams.end()))
+  {
+    DefaultMapper::map_task(ctx, task, input, output);
+    return;
+  }
+
+  Processor::Kind target_kind = task.target_proc.kind();
+  VariantInfo chosen = default_find_preferred_variant(task, ctx,
+                    true/*needs tight bound*/, true/*cache*/, target_kind);
+  output.chosen_variant = chosen.variant;
+  output.task_priority = 0;
+  output.postmap_task = false;
+  output.target_procs.push_back(task.target_proc);
+
+  for (unsigned idx = 0; idx < task.regions.size(); idx++)
+  {
+    if ((task.regions[idx].privilege == NO_ACCESS) ||
+        (task.regions[idx].privilege_fields.empty())) continue;
+    map_resident_region(ctx, task.regions[idx].region, finder->second,
+                        output.chosen_instances[idx],
+                        task.regions[idx].privilege_fields,
+                        task.regions[idx].tag == DAXBY_AOS_TAG);
+  }
+  runtime->acquire_instances(ctx, output.chosen_instances);
+}
+
+void DaxbyMapper::map_resident_region(const MapperContext ctx,
+                                      LogicalRegion region, Memory target,
+                                      std::vector<PhysicalInstance> &instances,
+                                      const std::set<FieldID> &privilege_fields,
+                                      bool aos)
+{
+  // SOA: one instance per field keeps the layout the DPU kernels expect and
+  // lets the X/Y and Z requirements of different tasks share instances.
+  // AOS: a single instance holding every field of the field space so its
+  // records have the same shape as the attached daxpy_t buffer.
+  std::vector<FieldID> all_fields;
+  if (aos)
+    runtime->get_field_space_fields(ctx, region.get_field_space(), all_fields);
+  else
+    all_fields.insert(all_fields.end(), privilege_fields.begin(),
+                      privilege_fields.end());
+  unsigned num_instances = aos ? 1 : all_fields.size();
+
+  for (unsigned idx = 0; idx < num_instances; idx++)
+  {
+    const MemoizationKey key(region, aos ? AOS_KEY : all_fields[idx], target);
+    std::map<MemoizationKey,PhysicalInstance>::const_iterator
+      finder = resident_instances.find(key);
+    if (finder != resident_instances.end()) {
+      instances.push_back(finder->second);
+      continue;
+    }
+
+    LayoutConstraintSet layout_constraints;
+    layout_constraints.add_constraint(
+        SpecializedConstraint(LEGION_AFFINE_SPECIALIZE));
+    std::vector<DimensionKind> dimension_ordering(2);
+    dimension_ordering[0] = aos ? DIM_F : DIM_X;
+    dimension_ordering[1] = aos ? DIM_X : DIM_F;
+    layout_constraints.add_constraint(OrderingConstraint(dimension_ordering,
+                                                         false/*contiguous*/));
+    layout_constraints.add_constraint(MemoryConstraint(target.kind()));
+    std::vector<FieldID> fields;
+    if (aos)
+      fields = all_fields;
+    else
+      fields.push_back(all_fields[idx]);
+    // AOS records keep the field space order, X then Y then Z
+    layout_constraints.add_constraint(FieldConstraint(fields,
+                                                      false/*contiguous*/,
+                                                      aos/*inorder*/));
+
+    std::vector<LogicalRegion> regions(1, region);
+    PhysicalInstance result; bool created;
+    if (!runtime->find_or_create_physical_instance(ctx, target,
+          layout_constraints, regions, result, created, true/*acquire*/,
+          GC_NEVER_PRIORITY)) {
+      log_mapper.error("ERROR: Daxby Mapper failed to allocate instance "
+                       "in MRAM " IDFMT, target.id);
+      assert(false);
+    }
+    instances.push_back(result);
+    resident_instances[key] = result;
+  }
+}
+
+void update_mappers(Machine machine, Runtime *runtime,
+                    const std::set<Processor> &local_procs)
+{
+  std::map<Processor, Memory>* proc_mrams = new std::map<Processor, Memory>();
+  std::map<Processor, unsigned> best_bandwidth;
+
+  std::vector<Machine::ProcessorMemoryAffinity> proc_mem_affinities;
+  machine.get_proc_mem_affinity(proc_mem_affinities);
+
+  // the MRAM bank of a DPU is the memory with the highest affinity to it
+  for (unsigned idx = 0; idx < proc_mem_affinities.size(); ++idx) {
+    Machine::ProcessorMemoryAffinity& affinity = proc_mem_affinities[idx];
+
+    // skip memories with no capacity for creating instances
+    if(affinity.m.capacity() == 0)
+      continue;
+
+    if (affinity.p.kind() != Processor::DPU_PROC)
+      continue;
+    if (affinity.m.kind() == Memory::SYSTEM_MEM)
+      continue;
+
+    std::map<Processor, unsigned>::iterator finder =
+      best_bandwidth.find(affinity.p);
+    if ((finder == best_bandwidth.end()) ||
+        (finder->second < affinity.bandwidth)) {
+      best_bandwidth[affinity.p] = affinity.bandwidth;
+      (*proc_mrams)[affinity.p] = affinity.m;
+    }
+  }
+
+  for (std::set<Processor>::const_iterator it = local_procs.begin();
+        it != local_procs.end(); it++)
+  {
+    DaxbyMapper* mapper = new DaxbyMapper(runtime->get_mapper_runtime(),
+                                          machine, *it, "daxby_mapper",
+                                          proc_mrams);
+    runtime->replace_default_mapper(mapper, *it);
+  }
+}
@@ -0,0 +1,81 @@
+/* Copyright 2024 Stanford University, Los Alamos National Laboratory,
+ *                Northwestern University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DAXBY_MAPPER_H__
+#define __DAXBY_MAPPER_H__
+
+#include "legion.h"
+#include "default_mapper.h"
+
+using namespace Legion;
+using namespace Legion::Mapping;
+
+enum {
+  // region requirement tag: keep the interleaved (AOS) layout of the
+  // attached daxpy_t buffer for the MRAM instance instead of splitting it
+  DAXBY_AOS_TAG = 1,
+};
+
+// Maps every region of a DPU task into the MRAM of the target DPU and keeps
+// the instance alive (GC_NEVER_PRIORITY) for the rest of the run, so repeated
+// launches over the same sub-regions find their data already resident and
+// only the final CPU task pulls it back to system memory.
+class DaxbyMapper : public DefaultMapper {
+public:
+  DaxbyMapper(MapperRuntime *rt, Machine machine, Processor local,
+              const char *mapper_name,
+              std::map<Processor, Memory>* proc_mrams);
+public:
+  void map_task(const MapperContext      ctx,
+                const Task&              task,
+                const MapTaskInput&      input,
+                      MapTaskOutput&     output) override;
+protected:
+  void map_resident_region(const MapperContext ctx, LogicalRegion region,
+                           Memory target,
+                           std::vector<PhysicalInstance> &instances,
+                           const std::set<FieldID> &privilege_fields,
+                           bool aos);
+protected:
+  std::map<Processor, Memory>& proc_mrams;
+protected:
+  // For memoizing mapping instances
+  struct MemoizationKey {
+  public:
+    MemoizationKey(LogicalRegion r, FieldID f, Memory m)
+      : region(r), fid(f), memory(m) { }
+  public:
+    inline bool operator<(const MemoizationKey &rhs) const
+    {
+      if (region < rhs.region) return true;
+      if (region != rhs.region) return false; // same as >
+      if (fid < rhs.fid) return true;
+      if (fid != rhs.fid) return false; // same as >
+      return (memory < rhs.memory);
+    }
+  public:
+    LogicalRegion region;
+    FieldID fid;
+    Memory memory;
+  };
+  // memoization field of the single all-field instance of an AOS region
+  static const FieldID AOS_KEY = LEGION_MAX_APPLICATION_FIELD_ID;
+  std::map<MemoizationKey,PhysicalInstance> resident_instances;
+};
+
+void update_mappers(Machine machine, Runtime *rt,
+                    const std::set<Processor> &local_procs);
+#endif // __DAXBY_MAPPER_H__
@@ -25,6 +25,8 @@
 #include <legion.h>
 /* common header between device and host */
 #include <common.h>
+/* pins DPU task instances in MRAM */
+#include "daxby_mapper.h"
 
 #if !defined(LEGION_USE_UPMEM)
 #error Legion not compiled with UPMEM enabled
@@ -32,26 +34,40 @@
 
 using namespace Legion;
 
-#if defined(INT32)
-#define RANDOM_NUMBER rand() % 8192
+// TYPE and its value range come from common.h, see make TYPE=<name>
+#if defined(TYPE_IS_FLOAT)
+#define RANDOM_NUMBER ((TYPE)drand48())
+#define COMPARE(x, y) compare_float<TYPE>(x, y)
+// partial sums are added in a different order on the DPUs
+#define COMPARE_ACC(x, y) (fabs((x) - (y)) <= 1e-9 * fabs(x))
+#define PRINT_EXPECTED(x, y)                                                   \
+  printf("expected %f, received %f --> ", (double)x, (double)y)
+#define PRINT_EXPECTED_ACC(x, y) PRINT_EXPECTED(x, y)
+#define PRINT_ALPHA(x) printf(" alpha = %f \n", (double)x)
+
+#else
+#define RANDOM_NUMBER ((TYPE)(rand() % VALUE_RANGE))
 #define COMPARE(x, y) compare_int(x, y)
-#define PRINT_EXPECTED(x, y) printf("expected %d, received %d --> ", x, y)
-
-#elif defined(DOUBLE)
-#define RANDOM_NUMBER drand48()
-#define COMPARE(x, y) compare_double(x, y)
-#define PRINT_EXPECTED(x, y) printf("expected %f, received %f --> ", x, y)
+#define COMPARE_ACC(x, y) ((x) == (y))
+#define PRINT_EXPECTED(x, y)                                                   \
+  printf("expected %lld, received %lld --> ", (long long)x, (long long)y)
+#define PRINT_EXPECTED_ACC(x, y) PRINT_EXPECTED(x, y)
+#define PRINT_ALPHA(x) printf(" alpha = %lld \n", (long long)x)
 #endif
 
 enum TaskIDs {
   TOP_LEVEL_TASK_ID,
   INIT_FIELD_TASK_ID,
+  DPU_INIT_FIELD_TASK_ID,
   DAXPY_TASK_ID,
+  REDUCE_TASK_ID,
   CHECK_TASK_ID,
 };
 
 typedef struct {
   TYPE alpha;
+  uint32_t seed;
+  DPU_LAUNCH_KERNELS kernel_id;
   Realm::Upmem::Kernel *kernel;
 } DPU_TASK_ARGS;
 
@@ -64,6 +80,12 @@ enum FieldIDs {
   FID_Z,
 };
 
+// one partial per sub-region, summed by check_task
+enum PartialFieldIDs {
+  FID_DOT,
+  FID_NORM,
+};
+
 typedef struct {
   TYPE x;
   TYPE y;
@@ -81,15 +103,34 @@ double get_cur_time() {
   return cur_time;
 }
 
-bool compare_double(double a, double b) {
-  return fabs(a - b) < std::numeric_limits<double>::epsilon();
+template <typename T> bool compare_float(T a, T b) {
+  return fabs(a - b) < std::numeric_limits<T>::epsilon();
+}
+
+bool compare_int(int64_t a, int64_t b) { return a == b; }
+
+// per phase timing in the format of the PrIM hosts, averaged over the reps
+void print_phase(const char *label, double seconds, int reps) {
+  printf("%s Time (ms): %f\t", label, seconds * 1000 / reps);
 }
 
-bool compare_int(int a, int b) { return a == b; }
+// the DPU tasks return the time their kernel ran, the points run on
+// different DPUs so the slowest one is the kernel time of the launch
+double launch_kernel_time(FutureMap &fm, int num_points) {
+  double kernel_time = 0;
+  for (int p = 0; p < num_points; p++) {
+    double t = fm.get_result<double>(DomainPoint(Point<1>(p)));
+    if (t > kernel_time)
+      kernel_time = t;
+  }
+  return kernel_time;
+}
 
 void top_level_task(const Task *task,
                     const std::vector<PhysicalRegion> &regions, Context ctx,
                     Runtime *runtime) {
+  // a single binary hosts every kernel in DPU_LAUNCH_KERNELS, it is loaded
+  // once here and stays resident for all of the launches below
   Realm::Upmem::Kernel *kern = new Realm::Upmem::Kernel(DPU_LAUNCH_BINARY);
   // the binary needs to be loaded before any memory operations
   kern->load();
@@ -97,6 +138,10 @@ void top_level_task(const Task *task,
   int num_elements = 256;
   int num_subregions = 32;
   int soa_flag = 0;
+  int dpu_init = 1;
+  int exp = 1;
+  int num_warmup = 0;
+  int num_reps = 1;
   // See if we have any command line arguments to parse
   // Note we now have a new command line parameter which specifies
   // how many subregions we should make.
@@ -109,10 +154,50 @@ void top_level_task(const Task *task,
         num_subregions = atoi(command_args.argv[++i]);
       if (!strcmp(command_args.argv[i], "-s"))
         soa_flag = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-dpu_init"))
+        dpu_init = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-x"))
+        exp = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-w"))
+        num_warmup = atoi(command_args.argv[++i]);
+      // -iters is the older name of -e
+      if (!strcmp(command_args.argv[i], "-e") ||
+          !strcmp(command_args.argv[i], "-iters"))
+        num_reps = atoi(command_args.argv[++i]);
     }
   }
-  printf("Running daxpy for %d elements...\n", num_elements);
+  assert(num_warmup >= 0 && num_reps > 0);
+  const int num_iters = num_warmup + num_reps;
+  // -x 0 is weak scaling, -n elements per sub-region; -x 1 is strong
+  // scaling, -n elements in total
+  if (exp == 0)
+    num_elements *= num_subregions;
+  // the DPU kernels move whole 8 byte words, so every sub-region has to
+  // start and end on one
+  assert(num_elements % num_subregions == 0 &&
+         (num_elements / num_subregions) * sizeof(TYPE) % 8 == 0 &&
+         "elements per sub-region must be a multiple of 8 / sizeof(TYPE)");
+  printf("Running daxpy for %d elements, %s scaling...\n", num_elements,
+         exp == 0 ? "weak" : "strong");
   printf("Partitioning data into %d sub-regions...\n", num_subregions);
+  printf("Initializing fields on the %s...\n", dpu_init ? "DPUs" : "CPUs");
+  printf("Running %d warmup and %d timed daxpy iterations...\n", num_warmup,
+         num_reps);
+
+  // Kernel::launch pushes DPU_LAUNCH_ARGS and boots one DPU at a time and
+  // the Realm UPMEM module has no rank-wide batched launch yet (see "Launch
+  // batching" in the README), so points that share a DPU are serialized.
+  // One sub-region per DPU keeps it to one argument push and launch per DPU.
+  {
+    Machine::ProcessorQuery dpu_procs(Machine::get_machine());
+    dpu_procs.only_kind(Processor::DPU_PROC);
+    int num_dpus = dpu_procs.count();
+    if (num_subregions > num_dpus)
+      printf("Warning: %d sub-regions on %d DPUs, each DPU runs %d "
+             "launches back-to-back, use -b %d for one launch per DPU\n",
+             num_subregions, num_dpus,
+             (num_subregions + num_dpus - 1) / num_dpus, num_dpus);
+  }
 
   // Create our logical regions using the same schemas as earlier examples
   Rect<1> elem_rect(0, num_elements - 1);
@@ -134,20 +219,37 @@ void top_level_task(const Task *task,
   LogicalRegion output_lr = runtime->create_logical_region(ctx, is, fs);
   runtime->attach_name(output_lr, "output_lr");
 
+  // dot and norm partials, one element per sub-region
+  Rect<1> partial_rect(0, num_subregions - 1);
+  IndexSpace partial_is = runtime->create_index_space(ctx, partial_rect);
+  runtime->attach_name(partial_is, "partial_is");
+  FieldSpace partial_fs = runtime->create_field_space(ctx);
+  runtime->attach_name(partial_fs, "partial_fs");
+  {
+    FieldAllocator allocator =
+        runtime->create_field_allocator(ctx, partial_fs);
+    allocator.allocate_field(sizeof(ACC_TYPE), FID_DOT);
+    runtime->attach_name(partial_fs, FID_DOT, "DOT");
+    allocator.allocate_field(sizeof(ACC_TYPE), FID_NORM);
+    runtime->attach_name(partial_fs, FID_NORM, "NORM");
+  }
+  LogicalRegion partial_lr =
+      runtime->create_logical_region(ctx, partial_is, partial_fs);
+  runtime->attach_name(partial_lr, "partial_lr");
+
+  // The attached buffers are left uninitialized: X and Y are produced
+  // exactly once by the init tasks below (in MRAM with -dpu_init 1, in
+  // place in these buffers otherwise) and Z is write-discard for daxpy.
+  double start_attach = get_cur_time();
   PhysicalRegion xy_pr, z_pr;
   TYPE *z_ptr = NULL;
   TYPE *xy_ptr = NULL;
-  TYPE *xyz_ptr = NULL;
+  daxpy_t *xyz_ptr = NULL;
   if (soa_flag == 0) { // SOA
     size_t xy_bytes = 2 * sizeof(TYPE) * (num_elements);
     xy_ptr = (TYPE *)malloc(xy_bytes);
     size_t z_bytes = sizeof(TYPE) * (num_elements);
     z_ptr = (TYPE *)malloc(z_bytes);
-    for (int j = 0; j < num_elements; j++) {
-      xy_ptr[j] = RANDOM_NUMBER;
-      xy_ptr[num_elements + j] = RANDOM_NUMBER;
-      z_ptr[j] = RANDOM_NUMBER;
-    }
     {
       printf("Attach SOA array fid %d, fid %d, ptr %p\n", FID_X, FID_Y, xy_ptr);
       AttachLauncher launcher(LEGION_EXTERNAL_INSTANCE, input_lr, input_lr);
@@ -177,7 +279,7 @@ void top_level_task(const Task *task,
     }
   } else { // AOS
     size_t total_bytes = sizeof(daxpy_t) * (num_elements);
-    daxpy_t *xyz_ptr = (daxpy_t *)malloc(total_bytes);
+    xyz_ptr = (daxpy_t *)malloc(total_bytes);
     std::vector<FieldID> layout_constraint_fields(3);
     layout_constraint_fields[0] = FID_X;
     layout_constraint_fields[1] = FID_Y;
@@ -206,6 +308,10 @@ void top_level_task(const Task *task,
       z_pr = runtime->attach_external_resource(ctx, launcher);
     }
   }
+  xy_pr.wait_until_valid();
+  z_pr.wait_until_valid();
+  double end_attach = get_cur_time();
+  printf("Attach array, attach done, time %f\n", end_attach - start_attach);
 
   // In addition to using rectangles and domains for launching index spaces
   // of tasks (see example 02), Legion also uses them for performing
@@ -253,10 +359,19 @@ void top_level_task(const Task *task,
   LogicalPartition output_lp =
       runtime->get_logical_partition(ctx, output_lr, ip);
   runtime->attach_name(output_lp, "output_lp");
+  IndexPartition partial_ip =
+      runtime->create_equal_partition(ctx, partial_is, color_is);
+  runtime->attach_name(partial_ip, "partial_ip");
+  LogicalPartition partial_lp =
+      runtime->get_logical_partition(ctx, partial_lr, partial_ip);
+  runtime->attach_name(partial_lp, "partial_lp");
 
   // Create our launch domain.  Note that is the same as color domain
   // as we are going to launch one task for each subregion we created.
   ArgumentMap arg_map;
+  // DPU requirements on X, Y and Z keep the attached layout in MRAM, with
+  // -s 1 the DPU kernels work on whole daxpy_t records
+  const MappingTagID layout_tag = soa_flag ? DAXBY_AOS_TAG : 0;
   double start_init = get_cur_time();
 
   // As in previous examples, we now want to launch tasks for initializing
@@ -265,8 +380,18 @@ void top_level_task(const Task *task,
   // the logical subregions created by our partitioning.  To express this
   // we create an IndexLauncher for launching an index space of tasks
   // the same as example 02.
-  IndexLauncher init_launcher(INIT_FIELD_TASK_ID, color_is,
-                              TaskArgument(NULL, 0), arg_map);
+  //
+  // With -dpu_init 1 (the default) the DPU variant runs the init kernel of
+  // the already loaded binary, so X and Y are generated in MRAM and never
+  // have to be produced on the host and pushed down.
+  DPU_TASK_ARGS init_args;
+  init_args.alpha = 0;
+  init_args.seed = rand();
+  init_args.kernel_id = kernel_init;
+  init_args.kernel = kern;
+  IndexLauncher init_launcher(
+      dpu_init ? DPU_INIT_FIELD_TASK_ID : INIT_FIELD_TASK_ID, color_is,
+      TaskArgument(&init_args, sizeof(DPU_TASK_ARGS)), arg_map);
 
   // For index space task launches we don't want to have to explicitly
   // enumerate separate region requirements for all points in our launch
@@ -295,6 +420,7 @@ void top_level_task(const Task *task,
   init_launcher.add_region_requirement(RegionRequirement(
       input_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, input_lr));
   init_launcher.region_requirements[0].add_field(FID_X);
+  init_launcher.region_requirements[0].tag = layout_tag;
   FutureMap fmi0 = runtime->execute_index_space(ctx, init_launcher);
 
   // Modify our region requirement to initialize the other field
@@ -308,17 +434,23 @@ void top_level_task(const Task *task,
   init_launcher.region_requirements[0].privilege_fields.clear();
   init_launcher.region_requirements[0].instance_fields.clear();
   init_launcher.region_requirements[0].add_field(FID_Y);
+  init_args.seed = rand();
+  init_launcher.argument = TaskArgument(&init_args, sizeof(DPU_TASK_ARGS));
   FutureMap fmi1 = runtime->execute_index_space(ctx, init_launcher);
   fmi1.wait_all_results();
   fmi0.wait_all_results();
   double end_init = get_cur_time();
   printf("Attach array, init done, time %f\n", end_init - start_init);
+  printf("Attach array, staging done, time %f\n",
+         (end_attach - start_attach) + (end_init - start_init));
 
   const TYPE alpha = RANDOM_NUMBER;
   double start_t = get_cur_time();
 
   DPU_TASK_ARGS args;
   args.alpha = alpha;
+  args.seed = 0;
+  args.kernel_id = kernel_daxpy;
   args.kernel = kern;
   // We launch the subtasks for performing the daxpy computation
   // in a similar way to the initialize field tasks.  Note we
@@ -331,13 +463,88 @@ void top_level_task(const Task *task,
       input_lp, 0 /*projection ID*/, READ_ONLY, EXCLUSIVE, input_lr));
   daxpy_launcher.region_requirements[0].add_field(FID_X);
   daxpy_launcher.region_requirements[0].add_field(FID_Y);
+  daxpy_launcher.region_requirements[0].tag = layout_tag;
   daxpy_launcher.add_region_requirement(RegionRequirement(
       output_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, output_lr));
   daxpy_launcher.region_requirements[1].add_field(FID_Z);
-  FutureMap fm = runtime->execute_index_space(ctx, daxpy_launcher);
-  fm.wait_all_results();
+  daxpy_launcher.region_requirements[1].tag = layout_tag;
+  // DaxbyMapper keeps every instance of the DPU tasks in MRAM, so only the
+  // first iteration pays for moving X and Y down; the remaining ones run
+  // against resident data and Z is not copied back until check_task.
+  // The timed reps split every launch into DPU Kernel, the slowest kernel
+  // of the launch, and CPU-DPU, the rest: moving inputs that are not
+  // resident yet plus launch overhead.
+  double first_iter = 0;
+  double steady_iters = 0;
+  double cpu_dpu_time = 0;
+  double dpu_kernel_time = 0;
+  for (int iter = 0; iter < num_iters; iter++) {
+    double start_iter = get_cur_time();
+    FutureMap fm = runtime->execute_index_space(ctx, daxpy_launcher);
+    fm.wait_all_results();
+    double end_iter = get_cur_time();
+    if (iter == 0)
+      first_iter = end_iter - start_iter;
+    else
+      steady_iters += end_iter - start_iter;
+    if (iter >= num_warmup) {
+      double kernel = launch_kernel_time(fm, num_subregions);
+      dpu_kernel_time += kernel;
+      cpu_dpu_time += (end_iter - start_iter) - kernel;
+    }
+    printf("daxpy iteration %d, time %f\n", iter, end_iter - start_iter);
+  }
   double end_t = get_cur_time();
   printf("Attach array, daxpy done, time %f\n", end_t - start_t);
+  if (num_iters > 1) {
+    // steady state iterations run against resident inputs. With -dpu_init 0
+    // the difference to the first one is what moving the inputs into MRAM
+    // cost; with -dpu_init 1 the inputs were made in MRAM and it is only the
+    // first launch and mapping overhead.
+    double steady_time = steady_iters / (num_iters - 1);
+    printf("daxpy steady time per iteration %f\n", steady_time);
+    printf("daxpy %s time %f\n", dpu_init ? "first launch overhead" : "transfer",
+           first_iter - steady_time);
+  }
+  double kernel_time = dpu_kernel_time / num_reps;
+  // X and Y read, Z written, whatever the layout
+  printf("daxpy %s %s throughput %f Melem/s %f MB/s\n", TYPE_NAME,
+         soa_flag ? "AOS" : "SOA", num_elements / kernel_time / 1e6,
+         3.0 * sizeof(TYPE) * num_elements / kernel_time / 1e6);
+
+  // Reductions reuse the loaded binary: dot(X, Y) and the squared norm of
+  // X, each DPU writes its partial into its own slot of partial_lr.
+  double start_red = get_cur_time();
+  args.kernel_id = kernel_dot;
+  IndexLauncher dot_launcher(REDUCE_TASK_ID, color_is,
+                             TaskArgument(&args, sizeof(DPU_TASK_ARGS)),
+                             arg_map);
+  dot_launcher.add_region_requirement(RegionRequirement(
+      input_lp, 0 /*projection ID*/, READ_ONLY, EXCLUSIVE, input_lr));
+  dot_launcher.region_requirements[0].add_field(FID_X);
+  dot_launcher.region_requirements[0].add_field(FID_Y);
+  dot_launcher.region_requirements[0].tag = layout_tag;
+  dot_launcher.add_region_requirement(RegionRequirement(
+      partial_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, partial_lr));
+  dot_launcher.region_requirements[1].add_field(FID_DOT);
+  FutureMap fmd = runtime->execute_index_space(ctx, dot_launcher);
+
+  args.kernel_id = kernel_norm;
+  IndexLauncher norm_launcher(REDUCE_TASK_ID, color_is,
+                              TaskArgument(&args, sizeof(DPU_TASK_ARGS)),
+                              arg_map);
+  norm_launcher.add_region_requirement(RegionRequirement(
+      input_lp, 0 /*projection ID*/, READ_ONLY, EXCLUSIVE, input_lr));
+  norm_launcher.region_requirements[0].add_field(FID_X);
+  norm_launcher.region_requirements[0].tag = layout_tag;
+  norm_launcher.add_region_requirement(RegionRequirement(
+      partial_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, partial_lr));
+  norm_launcher.region_requirements[1].add_field(FID_NORM);
+  FutureMap fmn = runtime->execute_index_space(ctx, norm_launcher);
+  fmd.wait_all_results();
+  fmn.wait_all_results();
+  double end_red = get_cur_time();
+  printf("Attach array, dot and norm done, time %f\n", end_red - start_red);
 
   // While we could also issue parallel subtasks for the checking
   // task, we only issue a single task launch to illustrate an
@@ -356,20 +563,37 @@ void top_level_task(const Task *task,
   check_launcher.add_region_requirement(
       RegionRequirement(output_lr, READ_ONLY, EXCLUSIVE, output_lr));
   check_launcher.region_requirements[1].add_field(FID_Z);
+  check_launcher.add_region_requirement(
+      RegionRequirement(partial_lr, READ_ONLY, EXCLUSIVE, partial_lr));
+  check_launcher.region_requirements[2].add_field(FID_DOT);
+  check_launcher.region_requirements[2].add_field(FID_NORM);
+  double start_check = get_cur_time();
   Future fu = runtime->execute_task(ctx, check_launcher);
-  fu.wait();
+  // Z and the partials are copied back before check_task starts, it
+  // returns when its body began
+  double check_begin = fu.get_result<double>();
+  double end_check = get_cur_time();
+  printf("Copy back and check done, time %f\n", end_check - start_check);
+
+  print_phase("CPU-DPU", cpu_dpu_time, num_reps);
+  print_phase("DPU Kernel", dpu_kernel_time, num_reps);
+  print_phase("DPU-CPU", check_begin - start_check, 1);
+  printf("\n");
 
   runtime->detach_external_resource(ctx, xy_pr);
   runtime->detach_external_resource(ctx, z_pr);
   runtime->destroy_logical_region(ctx, input_lr);
   runtime->destroy_logical_region(ctx, output_lr);
+  runtime->destroy_logical_region(ctx, partial_lr);
   runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_field_space(ctx, partial_fs);
   runtime->destroy_index_space(ctx, is);
-  if (xyz_ptr == NULL)
+  runtime->destroy_index_space(ctx, partial_is);
+  if (xyz_ptr != NULL)
     free(xyz_ptr);
-  if (xy_ptr == NULL)
+  if (xy_ptr != NULL)
     free(xy_ptr);
-  if (z_ptr == NULL)
+  if (z_ptr != NULL)
     free(z_ptr);
 }
 
@@ -395,8 +619,36 @@ void init_field_task(const Task *task,
     acc[*pir] = RANDOM_NUMBER;
 }
 
-void daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
-                Context ctx, Runtime *runtime) {
+void dpu_init_field_task(const Task *task,
+                         const std::vector<PhysicalRegion> &regions,
+                         Context ctx, Runtime *runtime) {
+  assert(regions.size() == 1);
+  assert(task->regions.size() == 1);
+  assert(task->regions[0].privilege_fields.size() == 1);
+  assert(task->arglen == sizeof(DPU_TASK_ARGS));
+  DPU_TASK_ARGS task_args = *((DPU_TASK_ARGS *)task->args);
+
+  FieldID fid = *(task->regions[0].privilege_fields.begin());
+  const int point = task->index_point.point_data[0];
+  printf("Initializing field %d for block %d on DPU...\n", fid, point);
+
+  const AccessorWD acc(regions[0], fid);
+
+  Rect<1> rect = runtime->get_index_space_domain(
+      ctx, task->regions[0].region.get_index_space());
+
+  {
+    DPU_LAUNCH_ARGS args;
+    args.seed = task_args.seed;
+    args.rect = rect;
+    args.acc_z = acc;
+    args.kernel = task_args.kernel_id;
+    task_args.kernel->launch((void **)&args, "ARGS", sizeof(DPU_LAUNCH_ARGS));
+  }
+}
+
+double daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
+                  Context ctx, Runtime *runtime) {
   assert(regions.size() == 2);
   assert(task->regions.size() == 2);
   assert(task->arglen == sizeof(DPU_TASK_ARGS));
@@ -413,11 +665,7 @@ void daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
   printf(
       "Running daxpy computation for point %d, xptr %p, y_ptr %p, z_ptr %p...",
       point, acc_x.ptr(rect.lo), acc_y.ptr(rect.lo), acc_z.ptr(rect.lo));
-#ifdef INT32
-  printf(" alpha = %d \n", alpha);
-#elif DOUBLE
-  printf(" alpha = %f \n", alpha);
-#endif
+  PRINT_ALPHA(alpha);
 
   {
     DPU_LAUNCH_ARGS args;
@@ -426,34 +674,83 @@ void daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
     args.acc_y = acc_y;
     args.acc_x = acc_x;
     args.acc_z = acc_z;
-    args.kernel = test;
-    // launch specific upmem kernel
+    args.kernel = task_args.kernel_id;
+    // launch specific upmem kernel, the regions are already in MRAM here
+    double start_kernel = get_cur_time();
     task_args.kernel->launch((void **)&args, "ARGS", sizeof(DPU_LAUNCH_ARGS));
+    return get_cur_time() - start_kernel;
   }
 }
 
-void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
-                Context ctx, Runtime *runtime) {
+void reduce_task(const Task *task, const std::vector<PhysicalRegion> &regions,
+                 Context ctx, Runtime *runtime) {
   assert(regions.size() == 2);
   assert(task->regions.size() == 2);
+  assert(task->arglen == sizeof(DPU_TASK_ARGS));
+  DPU_TASK_ARGS task_args = *((DPU_TASK_ARGS *)task->args);
+  const int point = task->index_point.point_data[0];
+
+  // dot reads X and Y, norm reads only the first field of its requirement
+  std::set<FieldID>::const_iterator fid =
+      task->regions[0].privilege_fields.begin();
+  const AccessorRO acc_x(regions[0], *fid);
+  FieldID fid_out = *(task->regions[1].privilege_fields.begin());
+  const AccessorWDacc acc_out(regions[1], fid_out);
+
+  Rect<1> rect = runtime->get_index_space_domain(
+      ctx, task->regions[0].region.get_index_space());
+  Rect<1> rect_out = runtime->get_index_space_domain(
+      ctx, task->regions[1].region.get_index_space());
+  printf("Running %s computation for point %d, xptr %p...\n",
+         task_args.kernel_id == kernel_dot ? "dot" : "norm", point,
+         acc_x.ptr(rect.lo));
+
+  {
+    DPU_LAUNCH_ARGS args;
+    args.rect = rect;
+    args.acc_x = acc_x;
+    if (task_args.kernel_id == kernel_dot) {
+      const AccessorRO acc_y(regions[0], FID_Y);
+      args.acc_y = acc_y;
+    }
+    args.acc_out = acc_out;
+    args.out = rect_out.lo;
+    args.kernel = task_args.kernel_id;
+    task_args.kernel->launch((void **)&args, "ARGS", sizeof(DPU_LAUNCH_ARGS));
+  }
+}
+
+double check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
+                  Context ctx, Runtime *runtime) {
+  double begin = get_cur_time();
+  assert(regions.size() == 3);
+  assert(task->regions.size() == 3);
   assert(task->arglen == sizeof(TYPE));
   const TYPE alpha = *((const TYPE *)task->args);
 
   const AccessorRO acc_x(regions[0], FID_X);
   const AccessorRO acc_y(regions[0], FID_Y);
   const AccessorRO acc_z(regions[1], FID_Z);
+  const AccessorROacc acc_dot(regions[2], FID_DOT);
+  const AccessorROacc acc_norm(regions[2], FID_NORM);
 
   Rect<1> rect = runtime->get_index_space_domain(
       ctx, task->regions[0].region.get_index_space());
+  Rect<1> partial_rect = runtime->get_index_space_domain(
+      ctx, task->regions[2].region.get_index_space());
   const void *ptr = acc_z.ptr(rect.lo);
   printf("Checking results... xptr %p, y_ptr %p, z_ptr %p...\n",
          acc_x.ptr(rect.lo), acc_y.ptr(rect.lo), ptr);
   bool all_passed = true;
   size_t count = 0;
   size_t errors = 0;
+  ACC_TYPE expected_dot = 0;
+  ACC_TYPE expected_norm = 0;
 
   for (PointInRectIterator<1> pir(rect); pir(); pir++) {
-    TYPE expected = alpha * acc_x[*pir] + acc_y[*pir];
+    expected_dot += (ACC_TYPE)acc_x[*pir] * acc_y[*pir];
+    expected_norm += (ACC_TYPE)acc_x[*pir] * acc_x[*pir];
+    TYPE expected = TYPE_MUL(alpha, acc_x[*pir]) + acc_y[*pir];
     TYPE received = acc_z[*pir];
     // Probably shouldn't check for floating point equivalence but
     // the order of operations are the same should they should
@@ -466,6 +763,28 @@ void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
     }
     count++;
   }
+
+  ACC_TYPE received_dot = 0;
+  ACC_TYPE received_norm = 0;
+  for (PointInRectIterator<1> pir(partial_rect); pir(); pir++) {
+    received_dot += acc_dot[*pir];
+    received_norm += acc_norm[*pir];
+  }
+  if (!COMPARE_ACC(expected_dot, received_dot)) {
+    all_passed = false;
+    PRINT_EXPECTED_ACC(expected_dot, received_dot);
+    printf("dot\n");
+    errors++;
+  }
+  if (!COMPARE_ACC(expected_norm, received_norm)) {
+    all_passed = false;
+    PRINT_EXPECTED_ACC(expected_norm, received_norm);
+    printf("norm\n");
+    errors++;
+  }
+  printf("dot %f, norm %f\n", (double)received_dot,
+         sqrt((double)received_norm));
+
   if (all_passed)
     printf("SUCCESS!\n");
   else {
@@ -473,6 +792,7 @@ void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
     printf("%ld ERRORS WERE FOUND\n", errors);
     abort();
   }
+  return begin;
 }
 
 int main(int argc, char **argv) {
@@ -491,19 +811,36 @@ int main(int argc, char **argv) {
     Runtime::preregister_task_variant<init_field_task>(registrar, "init_field");
   }
 
+  {
+    TaskVariantRegistrar registrar(DPU_INIT_FIELD_TASK_ID, "dpu_init_field");
+    registrar.add_constraint(ProcessorConstraint(Processor::DPU_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<dpu_init_field_task>(registrar,
+                                                           "dpu_init_field");
+  }
+
   {
     TaskVariantRegistrar registrar(DAXPY_TASK_ID, "daxpy");
     registrar.add_constraint(ProcessorConstraint(Processor::DPU_PROC));
     registrar.set_leaf();
-    Runtime::preregister_task_variant<daxpy_task>(registrar, "daxpy");
+    Runtime::preregister_task_variant<double, daxpy_task>(registrar, "daxpy");
+  }
+
+  {
+    TaskVariantRegistrar registrar(REDUCE_TASK_ID, "reduce");
+    registrar.add_constraint(ProcessorConstraint(Processor::DPU_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<reduce_task>(registrar, "reduce");
   }
 
   {
     TaskVariantRegistrar registrar(CHECK_TASK_ID, "check");
     registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
     registrar.set_leaf();
-    Runtime::preregister_task_variant<check_task>(registrar, "check");
+    Runtime::preregister_task_variant<double, check_task>(registrar, "check");
   }
 
+  Runtime::add_registration_callback(update_mappers);
+
   return Runtime::start(argc, argv);
 }
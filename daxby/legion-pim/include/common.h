@@ -22,24 +22,98 @@
 /* Brings in headers to define accessors */
 #include <realm/upmem/upmem_common.h>
 
+// element type, picked at build time with make TYPE=<name>. VALUE_RANGE
+// bounds the generated inputs so alpha * x + y still fits in TYPE, FIXED is
+// Q16.16 in an int32_t. dot and norm accumulate into a wider ACC_TYPE so
+// 2^22 products do not overflow; 8 bytes also keeps the per-DPU partial an
+// aligned MRAM transfer
+#undef TYPE
+#if defined(INT8)
+#define TYPE int8_t
+#define TYPE_NAME "int8"
+#define VALUE_RANGE 8
+typedef int64_t ACC_TYPE;
+#elif defined(INT16)
+#define TYPE int16_t
+#define TYPE_NAME "int16"
+#define VALUE_RANGE 128
+typedef int64_t ACC_TYPE;
+#elif defined(INT32)
+#define TYPE int32_t
+#define TYPE_NAME "int32"
+#define VALUE_RANGE 8192
+typedef int64_t ACC_TYPE;
+#elif defined(INT64)
+#define TYPE int64_t
+#define TYPE_NAME "int64"
+#define VALUE_RANGE 8192
+typedef int64_t ACC_TYPE;
+#elif defined(FIXED)
+#define TYPE int32_t
+#define TYPE_NAME "fixed"
+#define FIXED_FRAC_BITS 16
+#define VALUE_RANGE (8 << FIXED_FRAC_BITS)
+typedef int64_t ACC_TYPE;
+#elif defined(FLOAT)
+#define TYPE float
+#define TYPE_NAME "float"
+#define TYPE_IS_FLOAT
+typedef double ACC_TYPE;
+#elif defined(DOUBLE)
+#define TYPE double
+#define TYPE_NAME "double"
+#define TYPE_IS_FLOAT
+typedef double ACC_TYPE;
+#else
+#error TYPE must be one of INT8, INT16, INT32, INT64, FIXED, FLOAT, DOUBLE
+#endif
+
+// the DPU has no FPU and only an 8x8 bit multiplier, so the product is the
+// part of daxpy whose cost depends on TYPE
+#if defined(FIXED)
+#define TYPE_MUL(a, b) ((TYPE)(((int64_t)(a) * (b)) >> FIXED_FRAC_BITS))
+#else
+#define TYPE_MUL(a, b) ((TYPE)((a) * (b)))
+#endif
+
+// maps 32 random bits onto an input value for the DPU init; the CPU init
+// draws from the same range with RANDOM_NUMBER in upmem_legion_test.cc
+#if defined(TYPE_IS_FLOAT)
+#define RANDOM_VALUE(r) ((TYPE)((r) >> 8) * ((TYPE)1 / 16777216))
+#else
+#define RANDOM_VALUE(r) ((TYPE)((r) % VALUE_RANGE))
+#endif
+
 typedef FieldAccessor<LEGION_READ_ONLY,TYPE,1,coord_t,
                       Realm::AffineAccessor<TYPE,1,coord_t> > AccessorRO;
 typedef FieldAccessor<LEGION_WRITE_DISCARD,TYPE,1,coord_t,
                       Realm::AffineAccessor<TYPE,1,coord_t> > AccessorWD;
 
+typedef FieldAccessor<LEGION_READ_ONLY,ACC_TYPE,1,coord_t,
+                      Realm::AffineAccessor<ACC_TYPE,1,coord_t> > AccessorROacc;
+typedef FieldAccessor<LEGION_WRITE_DISCARD,ACC_TYPE,1,coord_t,
+                      Realm::AffineAccessor<ACC_TYPE,1,coord_t> > AccessorWDacc;
+
 
+// kernels hosted by dpu/dpu_test_realm.cc, selected per launch
 typedef enum DPU_LAUNCH_KERNELS{
-  test,
-  nr_kernels = 1
+  kernel_init,   // acc_z[i] = random value derived from (seed, i)
+  kernel_daxpy,  // acc_z[i] = alpha * acc_x[i] + acc_y[i]
+  kernel_dot,    // acc_out[out] = sum(acc_x[i] * acc_y[i])
+  kernel_norm,   // acc_out[out] = sum(acc_x[i] * acc_x[i])
+  nr_kernels = 4
 } DPU_LAUNCH_KERNELS;
 
 
 typedef struct DPU_LAUNCH_ARGS{
   TYPE alpha;
+  uint32_t seed;
   Rect<1> rect;
   AccessorRO acc_y;
   AccessorRO acc_x;
   AccessorWD acc_z;
+  AccessorWDacc acc_out;
+  Point<1> out;
   DPU_LAUNCH_KERNELS kernel;
   PADDING(8);
 } __attribute__((aligned(8))) DPU_LAUNCH_ARGS;
@@ -3,7 +3,9 @@
 #include <stdint.h>
 #include <stdlib.h>
 typedef int32_t T; 
-const uint32_t dpu_number = 4;
+// defaults, overridden at run time by the host flags / SIMPLEPIM_* variables
+uint32_t dpu_number = 4;
 uint32_t print_info = 0;
+uint32_t lazy_pipeline = 0; // fused map -> map -> reduce instead of map + gather
 uint64_t nr_elements = 4194304;
 #endif
@@ -4,12 +4,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "Param.h"
-#include "processing/map/MapArgs.h"
+#include "Map2Args.h"
 
-void start_func(map_arguments_t* args){}
+void start_func(map2_arguments_t* args){}
 
-void map_func(void* input, void* res){
-    *(T*)res = ((T*)input)[0] + ((T*)input)[1];
+void map_func(void* input1, void* input2, void* res){
+    *(T*)res = *(T*)input1 + *(T*)input2;
+}
+
+// Stages of the lazy pipeline fused behind map_func: square, then sum
+#define MAP2_CHAIN_FUNC
+void map_chain_func(void* elem){
+    *(T*)elem = *(T*)elem * *(T*)elem;
+}
+
+#define MAP2_REDUCE_FUNC
+void reduce_init_func(void* acc){
+    *(int64_t*)acc = 0;
+}
+
+void reduce_func(void* acc, void* elem){
+    *(int64_t*)acc += *(T*)elem;
+}
+
+void reduce_combine_func(void* acc, void* other){
+    *(int64_t*)acc += *(int64_t*)other;
 }
 
 #endif
\ No newline at end of file
@@ -19,6 +19,8 @@ extern "C" {
 #include <barrier.h>
 #include <defs.h>
 #include <mram.h>
+#include <mutex_pool.h>
+#include <perfcounter.h>
 #include <stdint.h>
 }
 
@@ -28,6 +30,8 @@ extern "C" {
 #include <common.h>
 
 #define BLOCK_SIZE 32
+// bytes of the reduction instance folded per tasklet and step
+#define FOLD_CHUNK 256
 
 typedef struct __DPU_LAUNCH_ARGS {
   char paddd[256];
@@ -37,24 +41,89 @@ __host __DPU_LAUNCH_ARGS ARGS;
 
 DPU_LAUNCH_ARGS *args = (DPU_LAUNCH_ARGS *)(&ARGS);
 
-int main_kernel1();
+int main_hst();
 
 // Barrier
 BARRIER_INIT(my_barrier, NR_TASKLETS);
 
-int (*kernels[nr_kernels])(void) = {main_kernel1};
+// private histogram of every tasklet, folded into histo[0] after the barrier;
+// in HST-L mode histo[0] is the only histogram
+HIST_TYPE *histo[NR_TASKLETS];
 
-int main(void) { return kernels[args->kernel](); }
+// HST-L: bin b is guarded by mutex b % 8, so tasklets only contend when
+// their bins hash to the same mutex
+MUTEX_POOL_INIT(hist_mutex, 8);
 
-int main_kernel1() {
+int (*kernels[nr_kernels])(void) = {main_hst};
+
+int main(void) {
+  // the program stays loaded between launches, so the heap left behind by
+  // the previous launch has to be released before this one allocates
+  if (me() == 0) {
+    mem_reset();
+#ifdef PERF_UPMEM
+    perfcounter_config(COUNT_CYCLES, true);
+#endif
+  }
+  barrier_wait(&my_barrier);
+  return kernels[args->kernel]();
+}
+
+// number of elements left in the block starting at point, capped at BLOCK_SIZE
+static inline unsigned int block_elements(Point<1> point, Rect<1> rect) {
+  coord_t remaining = rect.hi.value - point.value + 1;
+  return remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+}
+
+// HST-L updates go through the mutex guarding the bin
+template <bool SHARED>
+static inline void count(HIST_TYPE *histo, uint32_t bin) {
+  if (SHARED)
+    mutex_pool_lock(&hist_mutex, bin);
+  histo[bin] += 1;
+  if (SHARED)
+    mutex_pool_unlock(&hist_mutex, bin);
+}
+
+// bin of v is (v * bins) >> depth; for a power of two bin count that is
+// v >> shift, which keeps the DPU's emulated 32 bit multiply out of the loop
+template <bool POW2>
+static inline uint32_t bin_of(TYPE v, uint32_t bins, uint32_t depth,
+                              uint32_t shift) {
+  return POW2 ? (uint32_t)v >> shift : ((uint32_t)v * bins) >> depth;
+}
+
+// histogram of one WRAM block, indexed directly and unrolled by 4
+template <bool POW2, bool SHARED>
+static void histogram(HIST_TYPE *histo, const TYPE *input,
+                      unsigned int elements, uint32_t bins, uint32_t depth,
+                      uint32_t shift) {
+  unsigned int i = 0;
+  for (; i + 4 <= elements; i += 4) {
+    uint32_t b0 = bin_of<POW2>(input[i], bins, depth, shift);
+    uint32_t b1 = bin_of<POW2>(input[i + 1], bins, depth, shift);
+    uint32_t b2 = bin_of<POW2>(input[i + 2], bins, depth, shift);
+    uint32_t b3 = bin_of<POW2>(input[i + 3], bins, depth, shift);
+    count<SHARED>(histo, b0);
+    count<SHARED>(histo, b1);
+    count<SHARED>(histo, b2);
+    count<SHARED>(histo, b3);
+  }
+  for (; i < elements; i++)
+    count<SHARED>(histo, bin_of<POW2>(input[i], bins, depth, shift));
+}
+
+int main_hst() {
   unsigned int tasklet_id = me();
+  const uint32_t bins = args->bins;
+  const bool shared = HST_L(bins);
 
 #ifdef PRINT_UPMEM
   if (tasklet_id == 0) {
     printf("DEVICE:::: Running HST computation with xptr %p",
            args->acc_x.ptr(args->rect.lo));
 
-    printf("DEVICE::: my tasklet id is %d, the lower bound of the rect is %d \n", tasklet_id, args->rect_y.lo.value);
+    printf("DEVICE::: my tasklet id is %d, the lower bound of the rect is %d \n", tasklet_id, args->rect.lo.value);
   }
 #endif
 
@@ -62,92 +131,104 @@ int main_kernel1() {
   rect.lo = args->rect.lo + tasklet_id * BLOCK_SIZE;
   rect.hi = args->rect.hi;
 
-  AccessorWD block_acc_y;
   AccessorRO block_acc_x;
 
   // set base pointer for the new block accessors
   block_acc_x.accessor.base = (uintptr_t)mem_alloc((BLOCK_SIZE) * sizeof(TYPE));
-  block_acc_y.accessor.base = (uintptr_t)mem_alloc((args->bins) * sizeof(TYPE));
-  // set strides from base accessor
   block_acc_x.accessor.strides = args->acc_x.accessor.strides;
-  block_acc_y.accessor.strides = args->acc_y.accessor.strides;
-
-
-// #ifdef PRINT_UPMEM
-//   Rect<1> temp_rect;
-//   temp_rect.lo = 0;
-//   temp_rect.hi = 256 - 1;
-//   unsigned int range = temp_rect.hi.value - temp_rect.lo.value + 1;
-//   Legion::PointInRectIterator<1> pir_a(temp_rect);
-//   READ_BLOCK(*pir_a, args->acc_x, block_acc_x, 256 * sizeof(TYPE));
-//   unsigned int counter = 0;
-//   Rect<1> block_rect;
-//   block_rect.lo = 0;
-//   block_rect.hi = 256-1;
-//   for (Legion::PointInRectIterator<1> pir_block(block_rect); pir_block(); pir_block++) {
-//     if(counter%16==0) printf("\n");
-//     printf("%f ", block_acc_x[*pir_block]);
-//     counter++;
-//   }
-// #endif
-
-  Rect<1> output_rect;
-  output_rect.lo = args->rect_y.lo;
-  output_rect.hi = args->rect_y.lo+256;
-  Legion::PointInRectIterator<1> output_pir(output_rect);
-  READ_BLOCK(*output_pir, args->acc_y, block_acc_y, args->bins * sizeof(TYPE));
+  // HST-S: every tasklet counts into its own WRAM histogram, so the hot loop
+  // needs no synchronization; they are merged once all input is consumed.
+  // HST-L: tasklet 0 allocates the single histogram and all of them clear it
+  if (shared) {
+    if (tasklet_id == 0)
+      histo[0] = (HIST_TYPE *)mem_alloc(bins * sizeof(HIST_TYPE));
+    barrier_wait(&my_barrier);
+    for (uint32_t i = tasklet_id; i < bins; i += NR_TASKLETS)
+      histo[0][i] = 0;
+    barrier_wait(&my_barrier);
+  } else {
+    histo[tasklet_id] = (HIST_TYPE *)mem_alloc(bins * sizeof(HIST_TYPE));
+    for (uint32_t i = 0; i < bins; i++)
+      histo[tasklet_id][i] = 0;
+  }
+  HIST_TYPE *my_histo = histo[shared ? 0 : tasklet_id];
+  const TYPE *cache = (const TYPE *)block_acc_x.accessor.base;
 
+  const uint32_t depth = args->depth;
+  const uint32_t log2_bins = __builtin_ctz(bins);
+  const bool pow2 = (bins & (bins - 1)) == 0 && log2_bins <= depth;
+  const uint32_t shift = pow2 ? depth - log2_bins : 0;
 
   // iterate through all elements
   for (Legion::PointInRectIterator<1> pir(rect); pir();
        pir += (NR_TASKLETS * BLOCK_SIZE)) {
+    unsigned int elements = block_elements(*pir, rect);
 
     // read blocks to respective base pointers
     // #define READ_BLOCK(point, acc_full, acc_block, bytes)
     READ_BLOCK(*pir, args->acc_x, block_acc_x, BLOCK_SIZE * sizeof(TYPE));
-    // READ_BLOCK(*output_pir, args->acc_y, block_acc_y, args->bins * sizeof(TYPE));
-
-    Rect<1> block_rect;
-    block_rect.lo = 0;
-    block_rect.hi = BLOCK_SIZE-1;
-
-    Rect<1> bin_rect;
-    bin_rect.lo = 0;
-    bin_rect.hi = 256-1;
-
-    // block iterator
-    for (Legion::PointInRectIterator<1> pir_block(block_rect); pir_block();
-         pir_block++) {
-
-      TYPE curr_val = block_acc_x[*pir_block];
-      int bin_index = curr_val * args->bins >> args->depth;
-      Legion::PointInRectIterator<1> output_pir_block(bin_rect);
-      output_pir_block += (bin_index);
-      // for(int i=0; i<bin_index; i++) output_pir_block++;
-
-// #ifdef PRINT_UPMEM
-//       printf("the current value is %d and the corresponding index is %d\n", curr_val, bin_index);
-// #endif
 
+    if (shared) {
+      if (pow2)
+        histogram<true, true>(my_histo, cache, elements, bins, depth, shift);
+      else
+        histogram<false, true>(my_histo, cache, elements, bins, depth, shift);
+    } else {
+      if (pow2)
+        histogram<true, false>(my_histo, cache, elements, bins, depth, shift);
+      else
+        histogram<false, false>(my_histo, cache, elements, bins, depth, shift);
+    }
+  }
 
-      TYPE ori_bin_val = block_acc_y[*output_pir_block];
+  barrier_wait(&my_barrier);
 
-      block_acc_y.write(*output_pir_block, ori_bin_val + 1);
+  // each tasklet folds an interleaved slice of the bins into histo[0]
+  if (!shared) {
+    for (uint32_t i = tasklet_id; i < bins; i += NR_TASKLETS) {
+      HIST_TYPE b = 0;
+      for (unsigned int j = 0; j < NR_TASKLETS; j++)
+        b += histo[j][i];
+      histo[0][i] = b;
     }
 
-    // write block
-    // #define WRITE_BLOCK(point, acc_full, acc_block, bytes)
-    // WRITE_BLOCK(*pir, args->acc_z, block_acc_z, BLOCK_SIZE * sizeof(TYPE));
+    barrier_wait(&my_barrier);
   }
 
+#ifdef PERF_UPMEM
+  // cycles from the launch to the merged histogram, the writeback excluded
+  if (tasklet_id == 0) {
+    perfcounter_t cycles = perfcounter_get();
+    uint32_t elements = args->rect.hi.value - args->rect.lo.value + 1;
+    printf("DEVICE::: HST %u elements, %llu cycles, %llu cycles/element\n",
+           elements, (unsigned long long)cycles,
+           (unsigned long long)(cycles / elements));
+  }
+#endif
+
 #ifdef PRINT_UPMEM
-  for (Legion::PointInRectIterator<1> pir_block(output_rect); pir_block(); pir_block++) {
-    printf("the value is %d\n", block_acc_y[*pir_block]);
+  if (tasklet_id == 0) {
+    for (uint32_t i = 0; i < bins; i++)
+      printf("the value is %u\n", histo[0][i]);
   }
-  // fflush(stdout);
 #endif
 
-  WRITE_BLOCK(*output_pir, args->acc_y, block_acc_y, args->bins * sizeof(TYPE));
+  // fold the merged histogram into the reduction instance, the tasklets
+  // share the FOLD_CHUNK sized pieces. The runtime initializes the instance
+  // to the SUM identity, folding instead of overwriting keeps whatever it
+  // already holds
+  const uint32_t bytes = bins * sizeof(HIST_TYPE);
+  uintptr_t out = (uintptr_t)args->hist;
+  HIST_TYPE *fold = (HIST_TYPE *)mem_alloc(FOLD_CHUNK);
+  for (uint32_t offset = tasklet_id * FOLD_CHUNK; offset < bytes;
+       offset += NR_TASKLETS * FOLD_CHUNK) {
+    uint32_t chunk = bytes - offset < FOLD_CHUNK ? bytes - offset : FOLD_CHUNK;
+    const HIST_TYPE *merged = histo[0] + offset / sizeof(HIST_TYPE);
+    mram_read((const __mram_ptr void *)(out + offset), fold, chunk);
+    for (uint32_t i = 0; i < chunk / sizeof(HIST_TYPE); i++)
+      fold[i] += merged[i];
+    mram_write(fold, (__mram_ptr void *)(out + offset), chunk);
+  }
 
   return 0;
 }
@@ -14,17 +14,21 @@
  * limitations under the License.
  */
 
-//TODO: the exp mod
 //TODO: do we need the dynamic range handling?
-//TODO: do we need warm_up iteration
 //TODO: do we need exact the same program
 
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <limits>
 #include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <vector>
 
 #include <legion.h>
 #include <common.h>
@@ -38,33 +42,40 @@ using namespace Legion;
 
 
 #if defined(INT32)
-#define RANDOM_NUMBER rand() % 16384
 #define COMPARE(x, y) compare_int(x, y)
 #define PRINT_EXPECTED(x, y) printf("expected %d, received %d --> ", x, y)
 
 #elif defined(DOUBLE)
-#define RANDOM_NUMBER drand48()
 #define COMPARE(x, y) compare_double(x, y)
 #define PRINT_EXPECTED(x, y) printf("expected %f, received %f --> ", x, y)
 #endif
 
-#define DEPTH 14
-#define RANGE 16384
+// pixel depth and input image of PrIM HST-S, pixels are clamped to RANGE - 1
+#define DEPTH 12
+#define RANGE (1 << DEPTH)
+#define IMAGE_FILE "../../origin-benchmark/HST-S/input/image_VanHateren.iml"
+#define ByteSwap16(n) (((((unsigned int)n) << 8) & 0xFF00) | ((((unsigned int)n) >> 8) & 0x00FF))
+// default number of bins, -bins overrides it
 #define BINS 256
 
 enum TaskIDs {
   TOP_LEVEL_TASK_ID,
-  INIT_FIELD_TASK_ID,
   DAXPY_TASK_ID,
   CHECK_TASK_ID,
 };
 
 typedef struct {
-  TYPE bins;
-  TYPE depth;
+  uint32_t bins;
+  uint32_t depth;
   Realm::Upmem::Kernel *kernel;
 } DPU_TASK_ARGS;
 
+// every DPU task folds its histogram into the single bins-sized output
+// region, the runtime combines the per-DPU reduction instances
+typedef ReductionAccessor<SumReduction<HIST_TYPE>, true /*exclusive*/, 1,
+                          coord_t, Realm::AffineAccessor<HIST_TYPE, 1, coord_t> >
+    AccessorREDhist;
+
 #define DPU_LAUNCH_BINARY "dpu/dpu_test_realm.up.o"
 
 enum FieldIDs {
@@ -94,27 +105,109 @@ bool compare_double(double a, double b) {
 
 bool compare_int(int a, int b) { return a == b; }
 
+// prints one phase in the format PrIM uses for its timers, averaged over reps
+void print_phase(const char *label, double seconds, int reps) {
+  printf("%s Time (ms): %f\t", label, seconds * 1000 / reps);
+}
+
+// the DPU tasks return the time their kernel ran, the points run on
+// different DPUs so the slowest one is the kernel time of the launch
+double launch_kernel_time(FutureMap &fm, int num_points) {
+  double kernel_time = 0;
+  for (int p = 0; p < num_points; p++) {
+    double t = fm.get_result<double>(DomainPoint(Point<1>(p)));
+    if (t > kernel_time)
+      kernel_time = t;
+  }
+  return kernel_time;
+}
+
+// check_task reports when its body began, i.e. when the DPU histograms were
+// back on the host and merged, and how long the CPU histogram took
+struct CHECK_TIMES {
+  double begin;
+  double cpu;
+};
+
+// Read input_size big endian 16 bit pixels of a PrIM .iml image into A
+// through mmap, byte swapped and clamped like read_input() of PrIM HST-S
+static void read_input(TYPE *A, const char *file_name, int input_size) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    printf("%s does not exist\n", file_name);
+    exit(1);
+  }
+  struct stat st;
+  fstat(fd, &st);
+  if ((size_t)st.st_size < input_size * sizeof(unsigned short)) {
+    printf("%s holds fewer than %d pixels\n", file_name, input_size);
+    exit(1);
+  }
+  const unsigned short *pixels = (const unsigned short *)mmap(
+      NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  assert(pixels != MAP_FAILED);
+  for (int j = 0; j < input_size; j++) {
+    TYPE pixel = ByteSwap16(pixels[j]);
+    A[j] = pixel >= RANGE ? RANGE - 1 : pixel;
+  }
+  munmap((void *)pixels, st.st_size);
+  close(fd);
+}
+
 void top_level_task(const Task *task,
                     const std::vector<PhysicalRegion> &regions, Context ctx,
                     Runtime *runtime) {
   Realm::Upmem::Kernel *kern = new Realm::Upmem::Kernel(DPU_LAUNCH_BINARY);
   kern->load();
 
-  int num_elements = 16384;
+  int input_size = 1536 * 1024;
   int num_subregions = 4;
   int soa_flag = 0;
+  int bins = BINS;
+  int exp = 0;
+  int dpu_s = 64;
+  int num_warmup = 1;
+  int num_reps = 3;
+  const char *file_name = IMAGE_FILE;
   {
     const InputArgs &command_args = Runtime::get_input_args();
     for (int i = 1; i < command_args.argc; i++) {
       if (!strcmp(command_args.argv[i], "-n"))
-        num_elements = atoi(command_args.argv[++i]);
+        input_size = atoi(command_args.argv[++i]);
       if (!strcmp(command_args.argv[i], "-b"))
         num_subregions = atoi(command_args.argv[++i]);
       if (!strcmp(command_args.argv[i], "-s"))
         soa_flag = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-bins"))
+        bins = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-x"))
+        exp = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-z"))
+        dpu_s = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-f"))
+        file_name = command_args.argv[++i];
+      if (!strcmp(command_args.argv[i], "-w"))
+        num_warmup = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i], "-e"))
+        num_reps = atoi(command_args.argv[++i]);
     }
   }
-  printf("Running HST-S for %d elements...\n", num_elements);
+  // -n pixels are read from the image; as in PrIM HST-S -x 0 (weak scaling)
+  // gives every sub-region its own copy, -x 1 (strong scaling) splits one
+  // copy and -x 2 splits -z copies across the sub-regions
+  int num_elements = input_size;
+  if (exp == 0)
+    num_elements = input_size * num_subregions;
+  else if (exp == 2)
+    num_elements = input_size * dpu_s;
+  // every DPU writes its histogram back with 8 byte aligned MRAM transfers,
+  // HST-L still needs one full histogram in WRAM
+  assert(bins > 0 && bins % 2 == 0);
+  assert(bins * sizeof(HIST_TYPE) <= HIST_WRAM_BUDGET);
+  assert(num_warmup >= 0 && num_reps > 0);
+  printf("Running HST-S for %d elements of %s...\n", num_elements, file_name);
+  printf("Using %d bins, %s histogram on the DPU...\n", bins,
+         HST_L(bins) ? "shared (HST-L)" : "per-tasklet (HST-S)");
   printf("Partitioning data into %d sub-regions...\n", num_subregions);
 
   Rect<1> elem_rect(0, num_elements - 1);
@@ -128,14 +221,14 @@ void top_level_task(const Task *task,
     runtime->attach_name(fs, FID_X, "X");
   }
 
-  Rect<1> output_elem_rect(0, num_subregions*BINS - 1);
+  Rect<1> output_elem_rect(0, bins - 1);
   IndexSpace output_is = runtime->create_index_space(ctx, output_elem_rect);
   runtime->attach_name(output_is, "output_is");
   FieldSpace output_fs = runtime->create_field_space(ctx);
   runtime->attach_name(output_fs, "output_fs");
   {
     FieldAllocator allocator = runtime->create_field_allocator(ctx, output_fs);
-    allocator.allocate_field(sizeof(TYPE), FID_Y);
+    allocator.allocate_field(sizeof(HIST_TYPE), FID_Y);
     runtime->attach_name(output_fs, FID_Y, "Y");
   }
 
@@ -146,16 +239,20 @@ void top_level_task(const Task *task,
 
   PhysicalRegion x_pr, y_pr;
   TYPE *x_ptr = NULL;
-  TYPE *y_ptr = NULL;
+  HIST_TYPE *y_ptr = NULL;
   if (soa_flag == 0) { // SOA
     size_t x_bytes = sizeof(TYPE) * (num_elements);
     x_ptr = (TYPE *)malloc(x_bytes);
-    size_t y_bytes = sizeof(TYPE) * (num_subregions*BINS);
-    y_ptr = (TYPE *)malloc(y_bytes);
-    for (int j = 0; j < num_elements; j++) {
-      x_ptr[j] = 0;
-    }
-    for (int j = 0; j < num_subregions*BINS; j++) {
+    size_t y_bytes = sizeof(HIST_TYPE) * bins;
+    y_ptr = (HIST_TYPE *)malloc(y_bytes);
+    // the image is loaded straight into the buffer attached below
+    double start_load = get_cur_time();
+    read_input(x_ptr, file_name, input_size);
+    for (int j = input_size; j < num_elements; j += input_size)
+      memcpy(x_ptr + j, x_ptr, input_size * sizeof(TYPE));
+    double end_load = get_cur_time();
+    printf("Load image, time %f\n", end_load - start_load);
+    for (int j = 0; j < bins; j++) {
       y_ptr[j] = 0;
     }
     {
@@ -223,40 +320,17 @@ void top_level_task(const Task *task,
 
   IndexPartition ip = runtime->create_equal_partition(ctx, is, color_is);
   runtime->attach_name(ip, "ip");
-  IndexPartition output_ip = runtime->create_equal_partition(ctx, output_is, color_is);
-  runtime->attach_name(output_ip, "output_ip");
 
   LogicalPartition input_lp = runtime->get_logical_partition(ctx, input_lr, ip);
   runtime->attach_name(input_lp, "input_lp");
-  LogicalPartition output_lp = runtime->get_logical_partition(ctx, output_lr, output_ip);
-  runtime->attach_name(output_lp, "output_lp");
 
   ArgumentMap arg_map;
-  double start_init = get_cur_time();
-  // printf("before the init task\n");
-
-  IndexLauncher init_launcher(INIT_FIELD_TASK_ID, color_is,
-                              TaskArgument(NULL, 0), arg_map);
-
-  init_launcher.add_region_requirement(RegionRequirement(
-      input_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, input_lr));
-  init_launcher.region_requirements[0].add_field(FID_X);
-  FutureMap fmi0 = runtime->execute_index_space(ctx, init_launcher);
-
-  // init_launcher.region_requirements[0].privilege_fields.clear();
-  // init_launcher.region_requirements[0].instance_fields.clear();
-  // init_launcher.region_requirements[0].add_field(FID_Y);
-  // FutureMap fmi1 = runtime->execute_index_space(ctx, init_launcher);
-  // fmi1.wait_all_results();
-  fmi0.wait_all_results();
-  double end_init = get_cur_time();
-  printf("Attach array, init done, time %f\n", end_init - start_init);
 
   // const TYPE alpha = RANDOM_NUMBER;
   double start_t = get_cur_time();
 
   DPU_TASK_ARGS args;
-  args.bins = BINS;
+  args.bins = bins;
   args.depth = DEPTH;
   args.kernel = kern;
 
@@ -267,26 +341,73 @@ void top_level_task(const Task *task,
       input_lp, 0 /*projection ID*/, READ_ONLY, EXCLUSIVE, input_lr));
   daxpy_launcher.region_requirements[0].add_field(FID_X);
   // daxpy_launcher.region_requirements[0].add_field(FID_Y);
-  daxpy_launcher.add_region_requirement(RegionRequirement(
-      output_lp, 0 /*projection ID*/, WRITE_DISCARD, EXCLUSIVE, output_lr));
+  // every point reduces into all of output_lr, points using the same
+  // reduction operator do not interfere
+  daxpy_launcher.add_region_requirement(
+      RegionRequirement(output_lr, 0 /*projection ID*/, LEGION_REDOP_SUM_UINT32,
+                        EXCLUSIVE, output_lr));
   daxpy_launcher.region_requirements[1].add_field(FID_Y);
-  FutureMap fm = runtime->execute_index_space(ctx, daxpy_launcher);
-  fm.wait_all_results();
-  double end_t = get_cur_time();
-  printf("Attach array, HST done, time %f\n", end_t - start_t);
-
 
   TaskLauncher check_launcher(CHECK_TASK_ID,
-                              TaskArgument(NULL, 0));
+                              TaskArgument(&bins, sizeof(bins)));
   check_launcher.add_region_requirement(
       RegionRequirement(input_lr, READ_ONLY, EXCLUSIVE, input_lr));
   check_launcher.region_requirements[0].add_field(FID_X);
-  // check_launcher.region_requirements[0].add_field(FID_Y);
   check_launcher.add_region_requirement(
       RegionRequirement(output_lr, READ_ONLY, EXCLUSIVE, output_lr));
   check_launcher.region_requirements[1].add_field(FID_Y);
-  Future fu = runtime->execute_task(ctx, check_launcher);
-  fu.wait();
+
+  // every rep clears the histogram, runs HST and checks it like PrIM does;
+  // the image is read only so only rep 0 moves it into MRAM, after the -w
+  // warmup reps the phases are accumulated over -e reps. PrIM pushes the
+  // input every rep, so CPU-DPU is the launch overhead of the later reps
+  // plus the input transfer rep 0 paid on top of it.
+  double cpu_time = 0;
+  double first_touch_time = 0;
+  double launch_time = 0;
+  int launch_reps = 0;
+  double dpu_kernel_time = 0;
+  double dpu_cpu_time = 0;
+  for (int rep = 0; rep < num_warmup + num_reps; rep++) {
+    runtime->fill_field<HIST_TYPE>(ctx, output_lr, output_lr, FID_Y, 0);
+    double start_rep = get_cur_time();
+    FutureMap fm = runtime->execute_index_space(ctx, daxpy_launcher);
+    fm.wait_all_results();
+    double end_rep = get_cur_time();
+    printf("Attach array, HST rep %d done, time %f\n", rep,
+           end_rep - start_rep);
+
+    // the reduction instances are copied back and folded into output_lr
+    // before check_task starts
+    Future fu = runtime->execute_task(ctx, check_launcher);
+    CHECK_TIMES times = fu.get_result<CHECK_TIMES>();
+    double kernel = launch_kernel_time(fm, num_subregions);
+    if (rep == 0) {
+      first_touch_time = (end_rep - start_rep) - kernel;
+    } else if (rep >= num_warmup) {
+      launch_time += (end_rep - start_rep) - kernel;
+      launch_reps++;
+    }
+    if (rep >= num_warmup) {
+      dpu_kernel_time += kernel;
+      dpu_cpu_time += times.begin - end_rep;
+      cpu_time += times.cpu;
+    }
+  }
+  double end_t = get_cur_time();
+  printf("Attach array, HST done, time %f\n", end_t - start_t);
+  // without a measured rep after rep 0 the launch overhead cannot be told
+  // apart from the transfer, rep 0 then stands for both
+  double launch_avg =
+      launch_reps > 0 ? launch_time / launch_reps : first_touch_time;
+  double input_transfer_time =
+      first_touch_time > launch_avg ? first_touch_time - launch_avg : 0;
+  print_phase("CPU", cpu_time, num_reps);
+  print_phase("CPU-DPU", launch_avg + input_transfer_time, 1);
+  print_phase("Input transfer", input_transfer_time, 1);
+  print_phase("DPU Kernel", dpu_kernel_time, num_reps);
+  print_phase("DPU-CPU+merge", dpu_cpu_time, num_reps);
+  printf("\n");
 
   runtime->detach_external_resource(ctx, x_pr);
   runtime->detach_external_resource(ctx, y_pr);
@@ -296,48 +417,30 @@ void top_level_task(const Task *task,
   runtime->destroy_index_space(ctx, is);
   // if (xyz_ptr == NULL)
   //   free(xyz_ptr);
-  if (x_ptr == NULL)
+  if (x_ptr != NULL)
     free(x_ptr);
-  if (y_ptr == NULL)
+  if (y_ptr != NULL)
     free(y_ptr);
 }
 
-void init_field_task(const Task *task,
-                     const std::vector<PhysicalRegion> &regions, Context ctx,
-                     Runtime *runtime) {
-  assert(regions.size() == 1);
-  assert(task->regions.size() == 1);
-  assert(task->regions[0].privilege_fields.size() == 1);
-
-  FieldID fid = *(task->regions[0].privilege_fields.begin());
-  const int point = task->index_point.point_data[0];
-  printf("Initializing field %d for block %d...\n", fid, point);
-
-  const AccessorWD acc(regions[0], fid);
-
-  Rect<1> rect = runtime->get_index_space_domain(
-      ctx, task->regions[0].region.get_index_space());
-  for (PointInRectIterator<1> pir(rect); pir(); pir++)
-    acc[*pir] = RANDOM_NUMBER;
-}
-
-void daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
-                Context ctx, Runtime *runtime) {
+double daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
+                  Context ctx, Runtime *runtime) {
   assert(regions.size() == 2);
   assert(task->regions.size() == 2);
   assert(task->arglen == sizeof(DPU_TASK_ARGS));
   DPU_TASK_ARGS task_args = *((DPU_TASK_ARGS *)task->args);
-  const TYPE bins = task_args.bins;
-  const TYPE depth = task_args.depth;
+  const uint32_t bins = task_args.bins;
+  const uint32_t depth = task_args.depth;
   const int point = task->index_point.point_data[0];
 
-  const AccessorWD acc_y(regions[1], FID_Y);
+  const AccessorREDhist acc_y(regions[1], FID_Y, LEGION_REDOP_SUM_UINT32);
   const AccessorRO acc_x(regions[0], FID_X);
 
   Rect<1> rect = runtime->get_index_space_domain(
       ctx, task->regions[0].region.get_index_space());
   Rect<1> rect_y = runtime->get_index_space_domain(
       ctx, task->regions[1].region.get_index_space());
+  assert(rect_y.volume() == bins);
   printf(
       "Running HST computation for point %d, xptr %p...\n",
       point, acc_x.ptr(rect.lo));
@@ -350,24 +453,28 @@ void daxpy_task(const Task *task, const std::vector<PhysicalRegion> &regions,
     args.bins = bins;
     args.depth = depth;
     args.rect = rect;
-    args.rect_y = rect_y;
-    args.acc_y = acc_y;
+    args.hist = (uint64_t)(uintptr_t)acc_y.ptr(rect_y.lo);
     args.acc_x = acc_x;
-    args.kernel = test;
+    args.kernel = kernel_hst;
     // launch specific upmem kernel
+    double start_kernel = get_cur_time();
     task_args.kernel->launch((void **)&args, "ARGS", sizeof(DPU_LAUNCH_ARGS));
+    return get_cur_time() - start_kernel;
   }
 }
 
-void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
-                Context ctx, Runtime *runtime) {
+CHECK_TIMES check_task(const Task *task,
+                       const std::vector<PhysicalRegion> &regions, Context ctx,
+                       Runtime *runtime) {
+  CHECK_TIMES times;
+  times.begin = get_cur_time();
   assert(regions.size() == 2);
   assert(task->regions.size() == 2);
-  // assert(task->arglen == sizeof(TYPE));
-  // const TYPE alpha = *((const TYPE *)task->args);
+  assert(task->arglen == sizeof(int));
+  const int bins = *((const int *)task->args);
 
   const AccessorRO acc_x(regions[0], FID_X);
-  const AccessorRO acc_y(regions[1], FID_Y);
+  const AccessorROhist acc_y(regions[1], FID_Y);
   // const AccessorRO acc_z(regions[1], FID_Z);
 
   Rect<1> rect_x = runtime->get_index_space_domain(
@@ -377,27 +484,27 @@ void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
 
 
 
-  int* sum_hst[BINS];
-  for(int i=0; i<BINS; i++) sum_hst[i] = 0;
+  std::vector<int64_t> sum_hst(bins, 0);
+  double start_cpu = get_cur_time();
   for(PointInRectIterator<1> pir(rect_x); pir(); pir++){
-    sum_hst[acc_x[*pir]*BINS>>DEPTH]++;
+    sum_hst[acc_x[*pir]*bins>>DEPTH]++;
   }
+  times.cpu = get_cur_time() - start_cpu;
+  // the runtime already folded every DPU's histogram into output_lr
 #ifdef PRINT_UPMEM
     printf("the resulting values are:\n");
-    for(PointInRectIterator<1> pir(rect_y); pir(); pir++){
-      printf("%d\n", acc_y[*pir]);
+    for(int i=0; i<bins; i++){
+      printf("%u\n", acc_y[rect_y.lo + i]);
     }
 #endif
   fflush(stdout);
 
-  int counter = 0;
-  for(PointInRectIterator<1> pir(rect_y); pir(); pir++){
-    sum_hst[counter%BINS]-=acc_y[*pir];
-    counter++;
+  for(int i=0; i<bins; i++){
+    sum_hst[i]-=acc_y[rect_y.lo + i];
   }
 
   bool all_passed = true;
-  for(int i=0; i<BINS; i++){
+  for(int i=0; i<bins; i++){
     if(sum_hst[i]!=0) all_passed = false;
   }
   
@@ -407,6 +514,7 @@ void check_task(const Task *task, const std::vector<PhysicalRegion> &regions,
     printf("FAILURE!\n");
     abort();
   }
+  return times;
 }
 
 int main(int argc, char **argv) {
@@ -418,25 +526,19 @@ int main(int argc, char **argv) {
     Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
   }
 
-  {
-    TaskVariantRegistrar registrar(INIT_FIELD_TASK_ID, "init_field");
-    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
-    registrar.set_leaf();
-    Runtime::preregister_task_variant<init_field_task>(registrar, "init_field");
-  }
-
   {
     TaskVariantRegistrar registrar(DAXPY_TASK_ID, "daxpy");
     registrar.add_constraint(ProcessorConstraint(Processor::DPU_PROC));
     registrar.set_leaf();
-    Runtime::preregister_task_variant<daxpy_task>(registrar, "daxpy");
+    Runtime::preregister_task_variant<double, daxpy_task>(registrar, "daxpy");
   }
 
   {
     TaskVariantRegistrar registrar(CHECK_TASK_ID, "check");
     registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
     registrar.set_leaf();
-    Runtime::preregister_task_variant<check_task>(registrar, "check");
+    Runtime::preregister_task_variant<CHECK_TIMES, check_task>(registrar,
+                                                             "check");
   }
 
   return Runtime::start(argc, argv);
@@ -28,19 +28,33 @@ typedef FieldAccessor<LEGION_WRITE_DISCARD,TYPE,1,coord_t,
                       Realm::AffineAccessor<TYPE,1,coord_t> > AccessorWD;
 
 
+// histogram counters, uint32_t as in the PrIM HST-S kernel
+typedef uint32_t HIST_TYPE;
+typedef FieldAccessor<LEGION_READ_ONLY,HIST_TYPE,1,coord_t,
+                      Realm::AffineAccessor<HIST_TYPE,1,coord_t> > AccessorROhist;
+
+
+// WRAM set aside for histograms. NR_TASKLETS private copies are used while
+// they fit (HST-S), larger bin counts share one copy whose bins are guarded
+// by a pool of mutexes (HST-L)
+#define HIST_WRAM_BUDGET (32 * 1024)
+#define HST_L(bins) ((bins) * NR_TASKLETS * sizeof(HIST_TYPE) > HIST_WRAM_BUDGET)
+
+
 typedef enum DPU_LAUNCH_KERNELS{
-  test,
+  kernel_hst,
   nr_kernels = 1
 } DPU_LAUNCH_KERNELS;
 
-//alpha will stand for the bins
+// bins is the histogram size, an input value v falls into bin
+// (v * bins) >> depth; hist is the MRAM address of this point's SUM
+// reduction instance of the bins-sized histogram region
 typedef struct DPU_LAUNCH_ARGS{
-  TYPE bins;
-  TYPE depth;
+  uint32_t bins;
+  uint32_t depth;
   Rect<1> rect;
-  Rect<1> rect_y;
-  AccessorWD acc_y;
   AccessorRO acc_x;
+  uint64_t hist;
   DPU_LAUNCH_KERNELS kernel;
   PADDING(8);
 } __attribute__((aligned(8))) DPU_LAUNCH_ARGS;
@@ -19,10 +19,23 @@
 #include <stdint.h>
 
 #include <omp.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include "../../support/common.h"
 #include "../../support/timer.h"
 
+// Sub-histograms per thread. Consecutive elements go to different
+// sub-histograms, so runs of the same bin do not wait on the previous
+// increment; with AVX2 every vector lane owns one, so the lanes of a vector
+// never update the same counter.
+#ifdef __AVX2__
+#define SUB_HISTS 8
+#else
+#define SUB_HISTS 4
+#endif
+
 // Pointer declaration
 static T* A;
 static unsigned int* histo_host;
@@ -63,28 +76,78 @@ static void read_input(T* A, const Params p) {
     }
 }
 
+/**
+* @brief histogram of A[begin, end) into the SUB_HISTS zeroed sub-histograms
+* in sub, which are folded into sub[0, bins) at the end
+*/
+static void histogram_thread(unsigned int* sub, const T* A, unsigned int bins, unsigned int begin, unsigned int end) {
+    unsigned int j = begin;
+#ifdef __AVX2__
+    const __m256i v_bins = _mm256_set1_epi32(bins);
+    uint32_t idx[8] __attribute__((aligned(32)));
+    for (; j + 8 <= end; j += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(A + j));
+        __m256i b = _mm256_srli_epi32(_mm256_mullo_epi32(d, v_bins), DEPTH);
+        _mm256_store_si256((__m256i*)idx, b);
+        for (unsigned int l = 0; l < 8; l++)
+            sub[l * bins + idx[l]] += 1;
+    }
+#else
+    for (; j + SUB_HISTS <= end; j += SUB_HISTS) {
+        for (unsigned int l = 0; l < SUB_HISTS; l++)
+            sub[l * bins + ((A[j + l] * bins) >> DEPTH)] += 1;
+    }
+#endif
+    for (; j < end; j++)
+        sub[(A[j] * bins) >> DEPTH] += 1;
+
+    for (unsigned int l = 1; l < SUB_HISTS; l++) {
+        #pragma omp simd
+        for (unsigned int b = 0; b < bins; b++)
+            sub[b] += sub[l * bins + b];
+    }
+}
+
 /**
 * @brief compute output in the host
+* @param priv SUB_HISTS * bins counters per thread, every thread clears its own
 */
-static void histogram_host(unsigned int* histo, T* A, unsigned int bins, unsigned int nr_elements, int exp, unsigned int nr_of_dpus, int t) {
+static void histogram_host(unsigned int* histo, unsigned int* priv, T* A, unsigned int bins, unsigned int nr_elements, int exp, unsigned int nr_of_dpus, int t) {
 
     omp_set_num_threads(t);
 
     if(!exp){
+        // every DPU histograms its own copy of the input
         #pragma omp parallel for
         for (unsigned int i = 0; i < nr_of_dpus; i++) {
-            for (unsigned int j = 0; j < nr_elements; j++) {
-                T d = A[j];
-                histo[i * bins + ((d * bins) >> DEPTH)] += 1;
-            }
+            unsigned int* sub = priv + (size_t)omp_get_thread_num() * SUB_HISTS * bins;
+            memset(sub, 0, SUB_HISTS * bins * sizeof(unsigned int));
+            histogram_thread(sub, A, bins, 0, nr_elements);
+            memcpy(histo + i * bins, sub, bins * sizeof(unsigned int));
         }
     }
     else{
-        #pragma omp parallel for
-        for (unsigned int j = 0; j < nr_elements; j++) {
-            T d = A[j];
-            #pragma omp atomic update
-            histo[(d * bins) >> DEPTH] += 1;
+        // every thread histograms one slice of the input privately, then the
+        // bins are reduced across the threads
+        #pragma omp parallel
+        {
+            unsigned int tid = omp_get_thread_num();
+            unsigned int nr_threads = omp_get_num_threads();
+            unsigned int slice = divceil(nr_elements, nr_threads);
+            unsigned int begin = tid * slice < nr_elements ? tid * slice : nr_elements;
+            unsigned int end = begin + slice < nr_elements ? begin + slice : nr_elements;
+            unsigned int* sub = priv + (size_t)tid * SUB_HISTS * bins;
+            memset(sub, 0, SUB_HISTS * bins * sizeof(unsigned int));
+            histogram_thread(sub, A, bins, begin, end);
+
+            #pragma omp barrier
+            #pragma omp for
+            for (unsigned int b = 0; b < bins; b++) {
+                unsigned int sum = 0;
+                for (unsigned int i = 0; i < nr_threads; i++)
+                    sum += priv[(size_t)i * SUB_HISTS * bins + b];
+                histo[b] = sum;
+            }
         }
     }
 }
@@ -150,7 +213,8 @@ int main(int argc, char **argv) {
 
     struct Params p = input_params(argc, argv);
 
-    uint32_t nr_of_dpus;
+    // weak scaling histograms one copy of the input per thread
+    uint32_t nr_of_dpus = p.n_threads;
     
     const unsigned int input_size = p.input_size; // Size of input image
     if(!p.exp)
@@ -160,29 +224,46 @@ int main(int argc, char **argv) {
 
     // Input/output allocation
     A = malloc(input_size * sizeof(T));
-    T *bufferA = A;
     if(!p.exp)
         histo_host = malloc(nr_of_dpus * p.bins * sizeof(unsigned int));
     else
         histo_host = malloc(p.bins * sizeof(unsigned int));
+    unsigned int* priv = malloc((size_t)p.n_threads * SUB_HISTS * p.bins * sizeof(unsigned int));
 
     // Create an input file with arbitrary data.
     read_input(A, p);
 
     Timer timer;
-    start(&timer, 0, 0);
-
-	if(!p.exp)
-            memset(histo_host, 0, nr_of_dpus * p.bins * sizeof(unsigned int));
-    else
-            memset(histo_host, 0, p.bins * sizeof(unsigned int));
-
-    histogram_host(histo_host, A, p.bins, input_size, p.exp, nr_of_dpus, p.n_threads);
-
-    stop(&timer, 0);
+    for(int rep = 0; rep < p.n_warmup + p.n_reps; rep++) {
+        if(rep >= p.n_warmup)
+            start(&timer, 0, rep - p.n_warmup);
+        histogram_host(histo_host, priv, A, p.bins, input_size, p.exp, nr_of_dpus, p.n_threads);
+        if(rep >= p.n_warmup)
+            stop(&timer, 0);
+    }
     printf("Kernel ");
-    print(&timer, 0, 1);
+    print(&timer, 0, p.n_reps);
     printf("\n");
+
+    // Check output against a sequential histogram
+    unsigned int* histo_ref = calloc(p.bins, sizeof(unsigned int));
+    for (unsigned int j = 0; j < input_size; j++)
+        histo_ref[(A[j] * p.bins) >> DEPTH] += 1;
+    bool status = true;
+    for (unsigned int i = 0; i < (p.exp ? 1 : nr_of_dpus); i++)
+        for (unsigned int j = 0; j < p.bins; j++)
+            if (histo_host[i * p.bins + j] != histo_ref[j])
+                status = false;
+    if (status) {
+        printf("[" ANSI_COLOR_GREEN "OK" ANSI_COLOR_RESET "] Outputs are equal\n");
+    } else {
+        printf("[" ANSI_COLOR_RED "ERROR" ANSI_COLOR_RESET "] Outputs differ!\n");
+    }
+
+    free(A);
+    free(histo_host);
+    free(priv);
+    free(histo_ref);
 	
-    return 0;
+    return status ? 0 : -1;
 }
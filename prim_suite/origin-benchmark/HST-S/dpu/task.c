@@ -3,6 +3,7 @@
 *
 */
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <defs.h>
 #include <mram.h>
@@ -14,19 +15,22 @@
 
 __host dpu_arguments_t DPU_INPUT_ARGUMENTS;
 
+// Cycles every tasklet spent in every phase of the kernel
+__host uint64_t DPU_CYCLES[NR_TASKLETS * NR_PHASES];
+
 // Array for communication between adjacent tasklets
 uint32_t* message[NR_TASKLETS];
-// DPU histogram
-uint32_t* histo_dpu;
 
 // Barrier
 BARRIER_INIT(my_barrier, NR_TASKLETS);
 
-// Histogram in each tasklet
-static void histogram(uint32_t* histo, uint32_t bins, T *input, unsigned int l_size){
+// Histogram in each tasklet, of the bins [lo, lo + seg_bins) only
+static void histogram(uint32_t* histo, uint32_t bins, uint32_t lo, uint32_t seg_bins, T *input, unsigned int l_size){
     for(unsigned int j = 0; j < l_size; j++) {
         T d = input[j];
-        histo[(d * bins) >> DEPTH] += 1;
+        uint32_t b = ((d * bins) >> DEPTH) - lo;
+        if(b < seg_bins)
+            histo[b] += 1;
     }
 }
 
@@ -47,12 +51,14 @@ int main_kernel1() {
 #endif
     if (tasklet_id == 0){ // Initialize once the cycle counter
         mem_reset(); // Reset the heap
+        perfcounter_config(COUNT_CYCLES, true);
     }
     // Barrier
     barrier_wait(&my_barrier);
 
     uint32_t input_size_dpu_bytes = DPU_INPUT_ARGUMENTS.size;
     uint32_t input_size_dpu_bytes_transfer = DPU_INPUT_ARGUMENTS.transfer_size; // Transfer input size per DPU in bytes
+    uint32_t input_elements = DPU_INPUT_ARGUMENTS.elements; // the last slice of an odd input is padded
     uint32_t bins = DPU_INPUT_ARGUMENTS.bins;
 
     // Address of the current processing block in MRAM
@@ -62,55 +68,87 @@ int main_kernel1() {
 
     // Initialize a local cache to store the MRAM block
     T *cache_A = (T *) mem_alloc(BLOCK_SIZE);
+
+    // The DPU histogram lives in MRAM. Every pass histograms the segment of
+    // bins that fits in WRAM once per tasklet, all of them when they fit.
+    uint32_t seg_bins = HISTO_WRAM_BYTES / (NR_TASKLETS * sizeof(uint32_t));
+    seg_bins = seg_bins < bins ? seg_bins & ~1u : bins; // keeps segments 8-byte aligned in MRAM
 	
     // Local histogram
-    uint32_t *histo = (uint32_t *) mem_alloc(bins * sizeof(uint32_t));
-
-    // Initialize local histogram
-    for(unsigned int i = 0; i < bins; i++){
-        histo[i] = 0;
-    }
+    uint32_t *histo = (uint32_t *) mem_alloc(seg_bins * sizeof(uint32_t));
+    message[tasklet_id] = histo;
 
-    // Compute histogram
-    for(unsigned int byte_index = base_tasklet; byte_index < input_size_dpu_bytes; byte_index += BLOCK_SIZE * NR_TASKLETS){
+    perfcounter_t cycles[NR_PHASES] = {0};
+    perfcounter_t t0, t1;
 
-        // Bound checking
-        uint32_t l_size_bytes = (byte_index + BLOCK_SIZE >= input_size_dpu_bytes) ? (input_size_dpu_bytes - byte_index) : BLOCK_SIZE;
+    for(uint32_t lo = 0; lo < bins; lo += seg_bins){
+        uint32_t l_bins = bins - lo < seg_bins ? bins - lo : seg_bins;
 
-        // Load cache with current MRAM block
-        mram_read((const __mram_ptr void*)(mram_base_addr_A + byte_index), cache_A, l_size_bytes);
+        // Initialize local histogram
+        t0 = perfcounter_get();
+        for(unsigned int i = 0; i < l_bins; i++){
+            histo[i] = 0;
+        }
+        cycles[PHASE_COMPUTE] += perfcounter_get() - t0;
 
-        // Histogram in each tasklet
-        histogram(histo, bins, cache_A, l_size_bytes >> DIV);
+        // Compute histogram
+        for(unsigned int byte_index = base_tasklet; byte_index < input_size_dpu_bytes; byte_index += BLOCK_SIZE * NR_TASKLETS){
 
-    }
-    message[tasklet_id] = histo;
+            // Bound checking
+            uint32_t l_size_bytes = (byte_index + BLOCK_SIZE >= input_size_dpu_bytes) ? (input_size_dpu_bytes - byte_index) : BLOCK_SIZE;
 
-    // Barrier
-    barrier_wait(&my_barrier);
+            // Load cache with current MRAM block
+            t0 = perfcounter_get();
+            mram_read((const __mram_ptr void*)(mram_base_addr_A + byte_index), cache_A, l_size_bytes);
+            t1 = perfcounter_get();
+            cycles[PHASE_MRAM_READ] += t1 - t0;
 
-    uint32_t *histo_dpu = message[0];
+            // Histogram in each tasklet, without the padding
+            uint32_t l_elements = (byte_index >> DIV) + (l_size_bytes >> DIV) > input_elements ? input_elements - (byte_index >> DIV) : l_size_bytes >> DIV;
+            histogram(histo, bins, lo, l_bins, cache_A, l_elements);
+            cycles[PHASE_COMPUTE] += perfcounter_get() - t1;
 
-    for (unsigned int i = tasklet_id; i < bins; i += NR_TASKLETS){
-        uint32_t b = 0;		
-        for (unsigned int j = 0; j < NR_TASKLETS; j++){			
-            b += *(message[j] + i);
         }
-        histo_dpu[i] = b;
-    }
-
-    // Barrier
-    barrier_wait(&my_barrier);
 
-    // Write dpu histogram to current MRAM block
-    if(tasklet_id == 0){
-        if(bins * sizeof(uint32_t) <= 2048)
-            mram_write(histo_dpu, (__mram_ptr void*)(mram_base_addr_histo), bins * sizeof(uint32_t));
-        else 
-            for(unsigned int offset = 0; offset < ((bins * sizeof(uint32_t)) >> 11); offset++){
-                mram_write(histo_dpu + (offset << 9), (__mram_ptr void*)(mram_base_addr_histo + (offset << 11)), 2048);
+        // Barrier
+        barrier_wait(&my_barrier);
+
+        // Merge the tasklet histograms and write them back, every tasklet
+        // takes BLOCK_SIZE byte blocks of the segment. Streaming waves first
+        // read the histogram of the previous waves from MRAM.
+        uint32_t seg_bytes = l_bins * sizeof(uint32_t);
+        for(unsigned int byte_index = base_tasklet; byte_index < seg_bytes; byte_index += BLOCK_SIZE * NR_TASKLETS){
+            uint32_t l_size_bytes = (byte_index + BLOCK_SIZE >= seg_bytes) ? (seg_bytes - byte_index) : BLOCK_SIZE;
+            uint32_t mram_addr = mram_base_addr_histo + lo * sizeof(uint32_t) + byte_index;
+
+            t0 = perfcounter_get();
+            if(DPU_INPUT_ARGUMENTS.accumulate)
+                mram_read((const __mram_ptr void*)(mram_addr), cache_A, l_size_bytes);
+            else
+                for(unsigned int j = 0; j < l_size_bytes >> DIV; j++)
+                    cache_A[j] = 0;
+
+            for(unsigned int j = 0; j < l_size_bytes >> DIV; j++){
+                uint32_t b = 0;
+                for(unsigned int t = 0; t < NR_TASKLETS; t++){
+                    b += message[t][(byte_index >> DIV) + j];
+                }
+                cache_A[j] += b;
             }
+            t1 = perfcounter_get();
+            cycles[PHASE_MERGE] += t1 - t0;
+
+            // Write dpu histogram to current MRAM block
+            mram_write(cache_A, (__mram_ptr void*)(mram_addr), l_size_bytes);
+            cycles[PHASE_WRITEBACK] += perfcounter_get() - t1;
+        }
+
+        // Barrier
+        barrier_wait(&my_barrier);
     }
 
+    for(unsigned int i = 0; i < NR_PHASES; i++)
+        DPU_CYCLES[tasklet_id * NR_PHASES + i] = cycles[i];
+
     return 0;
 }
@@ -13,6 +13,7 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <assert.h>
+#include <omp.h>
 
 #include "../support/common.h"
 #include "../support/timer.h"
@@ -22,6 +23,8 @@
 #ifndef DPU_BINARY
 #define DPU_BINARY "./bin/dpu_code"
 #endif
+// DPU binaries prebuilt by the Makefile for a tasklet count and block size
+#define DPU_SWEEP_BINARY "./bin/dpu_code_tl%d_bl%d"
 
 #if ENERGY
 #include <dpu_probe.h>
@@ -31,6 +34,7 @@
 static T* A;
 static unsigned int* histo_host;
 static unsigned int* histo;
+static unsigned int* histo_sum;
 
 // Create input arrays
 static void read_input(T* A, const Params p) {
@@ -73,12 +77,138 @@ static void histogram_host(unsigned int* histo, T* A, unsigned int bins, unsigne
     }
 }
 
+// Merge the nr_of_dpus histograms laid out back to back in histo into
+// histo[0..bins). First every rank-sized group of DPUs is summed into its
+// first histogram, the groups in parallel; then the group partials are summed
+// with the bins split across the threads. The inner loops are unit stride so
+// they vectorize.
+static void merge_histograms(unsigned int* histo, unsigned int bins, unsigned int nr_of_dpus) {
+    const unsigned int nr_groups = divceil(nr_of_dpus, DPUS_PER_RANK);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (unsigned int g = 0; g < nr_groups; g++) {
+        unsigned int* dst = histo + g * DPUS_PER_RANK * bins;
+        unsigned int last = (g + 1) * DPUS_PER_RANK < nr_of_dpus ? (g + 1) * DPUS_PER_RANK : nr_of_dpus;
+        for (unsigned int i = g * DPUS_PER_RANK + 1; i < last; i++) {
+            const unsigned int* src = histo + i * bins;
+            #pragma omp simd
+            for (unsigned int j = 0; j < bins; j++)
+                dst[j] += src[j];
+        }
+    }
+
+    if (nr_groups > 1) {
+        #pragma omp parallel for schedule(static)
+        for (unsigned int j = 0; j < bins; j++) {
+            unsigned int b = histo[j];
+            for (unsigned int g = 1; g < nr_groups; g++)
+                b += histo[g * DPUS_PER_RANK * bins + j];
+            histo[j] = b;
+        }
+    }
+}
+
+// Push the arguments and the input of one chunk to every DPU. With
+// DPU_XFER_ASYNC the transfers are queued per rank and return immediately.
+static void push_chunk(struct dpu_set_t dpu_set, dpu_arguments_t* args, T* bufferA, unsigned int chunk,
+    unsigned int chunk_8bytes, unsigned int input_size_dpu_8bytes, dpu_xfer_flags_t flags) {
+    struct dpu_set_t dpu;
+    unsigned int i = 0;
+    DPU_FOREACH(dpu_set, dpu, i) {
+        DPU_ASSERT(dpu_prepare_xfer(dpu, &args[i]));
+    }
+    DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, "DPU_INPUT_ARGUMENTS", 0, sizeof(args[0]), flags));
+    DPU_FOREACH(dpu_set, dpu, i) {
+        DPU_ASSERT(dpu_prepare_xfer(dpu, bufferA + input_size_dpu_8bytes * i + chunk_8bytes * chunk));
+    }
+    DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, DPU_MRAM_HEAP_POINTER_NAME, 0, chunk_8bytes * sizeof(T), flags));
+}
+
+// Retrieve the histogram every DPU wrote behind its chunk into histo
+static void pull_histograms(struct dpu_set_t dpu_set, unsigned int* histo, unsigned int bins,
+    unsigned int chunk_8bytes, dpu_xfer_flags_t flags) {
+    struct dpu_set_t dpu;
+    unsigned int i = 0;
+    DPU_FOREACH(dpu_set, dpu, i) {
+        DPU_ASSERT(dpu_prepare_xfer(dpu, histo + bins * i));
+    }
+    DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, DPU_MRAM_HEAP_POINTER_NAME, chunk_8bytes * sizeof(T), bins * sizeof(unsigned int), flags));
+}
+
+// Gather the per tasklet kernel cycles of every DPU and add, per phase, the
+// slowest DPU's average over its tasklets to phase_cycles
+static void gather_cycles(struct dpu_set_t dpu_set, uint64_t* cycles, unsigned int nr_of_dpus, unsigned int nr_tasklets, double* phase_cycles) {
+    struct dpu_set_t dpu;
+    unsigned int i = 0;
+    DPU_FOREACH(dpu_set, dpu, i) {
+        DPU_ASSERT(dpu_prepare_xfer(dpu, cycles + i * nr_tasklets * NR_PHASES));
+    }
+    DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, "DPU_CYCLES", 0, nr_tasklets * NR_PHASES * sizeof(uint64_t), DPU_XFER_DEFAULT));
+    for (unsigned int ph = 0; ph < NR_PHASES; ph++) {
+        double max_dpu = 0;
+        for (i = 0; i < nr_of_dpus; i++) {
+            double sum = 0;
+            for (unsigned int t = 0; t < nr_tasklets; t++)
+                sum += cycles[(i * nr_tasklets + t) * NR_PHASES + ph];
+            if (sum / nr_tasklets > max_dpu)
+                max_dpu = sum / nr_tasklets;
+        }
+        phase_cycles[ph] += max_dpu;
+    }
+}
+
+// Append one row with the configuration, the timers (ms per rep), the DPU
+// cycles per phase (per rep) and the energy of the run to csv_file
+static void write_csv(const Params p, unsigned int nr_of_dpus, unsigned int input_size, unsigned int n_chunks,
+    Timer* timer, double* phase_cycles, double energy, bool status) {
+    FILE* f = fopen(p.csv_file, "a");
+    if (f == NULL) {
+        printf("%s cannot be opened\n", p.csv_file);
+        return;
+    }
+    if (ftell(f) == 0)
+        fprintf(f, "nr_dpus,nr_tasklets,bl,bins,input_size,exp,chunks,stream,async,"
+            "cpu_ms,cpu_dpu_ms,dpu_kernel_ms,dpu_cpu_ms,merge_ms,pipeline_ms,"
+            "mram_read_cycles,compute_cycles,merge_cycles,writeback_cycles,energy_j,status\n");
+    fprintf(f, "%u,%d,%d,%u,%u,%d,%u,%d,%d", nr_of_dpus, p.n_tasklets, p.bl, p.bins, input_size, p.exp, n_chunks, p.stream, p.async);
+    for (int t = 0; t < 6; t++)
+        fprintf(f, ",%f", t < 5 || p.async ? timer->time[t] / (1000 * p.n_reps) : 0.0);
+    for (int ph = 0; ph < NR_PHASES; ph++)
+        fprintf(f, ",%.0f", phase_cycles[ph] / p.n_reps);
+    fprintf(f, ",%f,%d\n", energy, status);
+    fclose(f);
+}
+
+// Arguments of the callback that merges the histograms of one rank
+typedef struct {
+    unsigned int* histo;          // histograms pulled from all DPUs
+    unsigned int* histo_rank;     // one running histogram per rank
+    unsigned int* rank_first_dpu; // index of the first DPU of every rank
+    unsigned int* rank_nr_dpus;   // DPUs in every rank
+    unsigned int bins;
+} merge_rank_args_t;
+
+// Runs in the queue of one rank after its histograms were pulled, so the next
+// chunk of that rank cannot overwrite them before they are merged, while the
+// other ranks keep transferring and computing
+static dpu_error_t merge_rank(struct dpu_set_t rank, uint32_t rank_id, void* arg) {
+    (void)rank;
+    merge_rank_args_t* m = (merge_rank_args_t*)arg;
+    unsigned int* dst = m->histo_rank + rank_id * m->bins;
+    for (unsigned int i = m->rank_first_dpu[rank_id]; i < m->rank_first_dpu[rank_id] + m->rank_nr_dpus[rank_id]; i++) {
+        const unsigned int* src = m->histo + i * m->bins;
+        for (unsigned int j = 0; j < m->bins; j++)
+            dst[j] += src[j];
+    }
+    return DPU_OK;
+}
+
 // Main of the Host Application
 int main(int argc, char **argv) {
 
     struct Params p = input_params(argc, argv);
 
-    struct dpu_set_t dpu_set, dpu;
+    struct dpu_set_t dpu_set;
     uint32_t nr_of_dpus;
     
 #if ENERGY
@@ -87,8 +217,15 @@ int main(int argc, char **argv) {
 #endif
 
     // Allocate DPUs and load binary
-    DPU_ASSERT(dpu_alloc(NR_DPUS, NULL, &dpu_set));
-    DPU_ASSERT(dpu_load(dpu_set, DPU_BINARY, NULL));
+    // -d 0 takes every available DPU; -t/-l pick a prebuilt binary, so a
+    // sweep over DPUs, tasklets and block sizes runs from one build
+    char dpu_binary[64];
+    if(p.n_tasklets == NR_TASKLETS && p.bl == BL)
+        snprintf(dpu_binary, sizeof(dpu_binary), "%s", DPU_BINARY);
+    else
+        snprintf(dpu_binary, sizeof(dpu_binary), DPU_SWEEP_BINARY, p.n_tasklets, p.bl);
+    DPU_ASSERT(dpu_alloc(p.n_dpus == 0 ? DPU_ALLOCATE_ALL : (uint32_t)p.n_dpus, NULL, &dpu_set));
+    DPU_ASSERT(dpu_load(dpu_set, dpu_binary, NULL));
     DPU_ASSERT(dpu_get_nr_dpus(dpu_set, &nr_of_dpus));
     printf("Allocated %d DPU(s)\n", nr_of_dpus);
 
@@ -102,17 +239,30 @@ int main(int argc, char **argv) {
     else
         input_size = p.input_size * dpu_s; // Size of input image
 
-    const unsigned int input_size_8bytes = 
-        ((input_size * sizeof(T)) % 8) != 0 ? roundup(input_size, 8) : input_size; // Input size per DPU (max.), 8-byte aligned
     const unsigned int input_size_dpu = divceil(input_size, nr_of_dpus); // Input size per DPU (max.)
     const unsigned int input_size_dpu_8bytes = 
         ((input_size_dpu * sizeof(T)) % 8) != 0 ? roundup(input_size_dpu, 8) : input_size_dpu; // Input size per DPU (max.), 8-byte aligned
 
-    // Input/output allocation
-    A = malloc(input_size_dpu_8bytes * nr_of_dpus * sizeof(T));
+    // Every DPU processes its input in n_chunks chunks, each chunk is pushed,
+    // histogrammed and pulled before the next one is pushed. Streaming uses at
+    // least as many chunks as it takes for every wave to fit in MRAM and only
+    // pulls the histograms the DPUs accumulated after the last wave.
+    unsigned int n_chunks = p.n_chunks;
+    if(p.stream) {
+        const unsigned int n_waves = divceil((uint64_t)input_size_dpu_8bytes * sizeof(T), MRAM_WAVE_BYTES);
+        if(n_chunks < n_waves)
+            n_chunks = n_waves;
+    }
+    const unsigned int chunk_size = divceil(input_size_dpu_8bytes, n_chunks); // Chunk size per DPU (max.)
+    const unsigned int chunk_8bytes = 
+        ((chunk_size * sizeof(T)) % 8) != 0 ? roundup(chunk_size, 8) : chunk_size; // Chunk size per DPU (max.), 8-byte aligned
+
+    // Input/output allocation, the last chunk of the last DPU may run past its input
+    A = malloc(((size_t)input_size_dpu_8bytes * (nr_of_dpus - 1) + (size_t)chunk_8bytes * n_chunks) * sizeof(T));
     T *bufferA = A;
     histo_host = malloc(p.bins * sizeof(unsigned int));
     histo = malloc(nr_of_dpus * p.bins * sizeof(unsigned int));
+    histo_sum = malloc(p.bins * sizeof(unsigned int));
 
     // Create an input file with arbitrary data
     read_input(A, p);
@@ -126,15 +276,61 @@ int main(int argc, char **argv) {
             memcpy(&A[j * p.input_size], &A[0], p.input_size * sizeof(T));
     }
 
+    // Input arguments of every chunk, they stay alive while asynchronous
+    // transfers are queued
+    unsigned int kernel = 0;
+    dpu_arguments_t* input_arguments = malloc(n_chunks * nr_of_dpus * sizeof(dpu_arguments_t));
+    for(unsigned int k = 0; k < n_chunks; k++) {
+        for(i = 0; i < nr_of_dpus; i++) {
+            // the part of [i * input_size_dpu_8bytes, input_size) inside the input, with
+            // many DPUs the slices of the last ones can be short or empty
+            uint64_t first = (uint64_t)i * input_size_dpu_8bytes;
+            unsigned int size_dpu = first >= input_size ? 0 : (input_size - first < input_size_dpu_8bytes ? input_size - first : input_size_dpu_8bytes);
+            unsigned int begin = k * chunk_8bytes;
+            unsigned int size = begin >= size_dpu ? 0 : (size_dpu - begin < chunk_8bytes ? size_dpu - begin : chunk_8bytes);
+            input_arguments[k * nr_of_dpus + i].size=(size * sizeof(T) + 7) & ~7u;
+            input_arguments[k * nr_of_dpus + i].elements=size;
+            input_arguments[k * nr_of_dpus + i].transfer_size=chunk_8bytes * sizeof(T);
+            input_arguments[k * nr_of_dpus + i].bins=p.bins;
+            input_arguments[k * nr_of_dpus + i].accumulate=p.stream && k > 0;
+            input_arguments[k * nr_of_dpus + i].kernel=kernel;
+        }
+    }
+
+    // DPUs of every rank for the per rank merge of the asynchronous pipeline
+    uint32_t nr_of_ranks;
+    DPU_ASSERT(dpu_get_nr_ranks(dpu_set, &nr_of_ranks));
+    unsigned int* rank_first_dpu = malloc(nr_of_ranks * sizeof(unsigned int));
+    unsigned int* rank_nr_dpus = malloc(nr_of_ranks * sizeof(unsigned int));
+    unsigned int* histo_rank = malloc(nr_of_ranks * p.bins * sizeof(unsigned int));
+    unsigned int* histo_pipe = malloc(p.bins * sizeof(unsigned int));
+    {
+        struct dpu_set_t rank;
+        uint32_t each_rank, first_dpu = 0;
+        DPU_RANK_FOREACH(dpu_set, rank, each_rank) {
+            uint32_t nr_rank_dpus;
+            DPU_ASSERT(dpu_get_nr_dpus(rank, &nr_rank_dpus));
+            rank_first_dpu[each_rank] = first_dpu;
+            rank_nr_dpus[each_rank] = nr_rank_dpus;
+            first_dpu += nr_rank_dpus;
+        }
+    }
+    merge_rank_args_t merge_args = {histo, histo_rank, rank_first_dpu, rank_nr_dpus, p.bins};
+
+    // Kernel cycles of every tasklet of every DPU, summed per phase over the
+    // launches of the timed reps
+    uint64_t* dpu_cycles = malloc(nr_of_dpus * p.n_tasklets * NR_PHASES * sizeof(uint64_t));
+    double phase_cycles[NR_PHASES] = {0};
+
     // Timer declaration
     Timer timer;
 
-    printf("NR_TASKLETS\t%d\tBL\t%d\tinput_size\t%u\n", NR_TASKLETS, BL, input_size);
+    printf("NR_TASKLETS\t%d\tBL\t%d\tinput_size\t%u\tchunks\t%u%s\n", p.n_tasklets, p.bl, input_size, n_chunks, p.stream ? "\tstreaming" : "");
 
     // Loop over main kernel
     for(int rep = 0; rep < p.n_warmup + p.n_reps; rep++) {
         memset(histo_host, 0, p.bins * sizeof(unsigned int));
-        memset(histo, 0, nr_of_dpus * p.bins * sizeof(unsigned int));
+        memset(histo_sum, 0, p.bins * sizeof(unsigned int));
 
         // Compute output on CPU (performance comparison and verification purposes)
         if(rep >= p.n_warmup)
@@ -143,85 +339,102 @@ int main(int argc, char **argv) {
         if(rep >= p.n_warmup)
             stop(&timer, 0);
 
-        printf("Load input data\n");
-        if(rep >= p.n_warmup)
-            start(&timer, 1, rep - p.n_warmup);
-        // Input arguments
-        unsigned int kernel = 0;
-        i = 0;
-	    dpu_arguments_t input_arguments[NR_DPUS];
-	    for(i=0; i<nr_of_dpus-1; i++) {
-	        input_arguments[i].size=input_size_dpu_8bytes * sizeof(T); 
-	        input_arguments[i].transfer_size=input_size_dpu_8bytes * sizeof(T); 
-	        input_arguments[i].bins=p.bins;
-	        input_arguments[i].kernel=kernel;
-	    }
-	    input_arguments[nr_of_dpus-1].size=(input_size_8bytes - input_size_dpu_8bytes * (NR_DPUS-1)) * sizeof(T); 
-	    input_arguments[nr_of_dpus-1].transfer_size=input_size_dpu_8bytes * sizeof(T); 
-	    input_arguments[nr_of_dpus-1].bins=p.bins;
-	    input_arguments[nr_of_dpus-1].kernel=kernel;
-
-        // Copy input arrays
-        i = 0;
-        DPU_FOREACH(dpu_set, dpu, i) {
-            DPU_ASSERT(dpu_prepare_xfer(dpu, &input_arguments[i]));
-        }
-        DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, "DPU_INPUT_ARGUMENTS", 0, sizeof(input_arguments[0]), DPU_XFER_DEFAULT));
-        DPU_FOREACH(dpu_set, dpu, i) {
-            DPU_ASSERT(dpu_prepare_xfer(dpu, bufferA + input_size_dpu_8bytes * i));
-        }
-        DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, DPU_MRAM_HEAP_POINTER_NAME, 0, input_size_dpu_8bytes * sizeof(T), DPU_XFER_DEFAULT));
-        if(rep >= p.n_warmup)
-            stop(&timer, 1);
-
-        printf("Run program on DPU(s) \n");
-        // Run DPU kernel
-        if(rep >= p.n_warmup) {
-            start(&timer, 2, rep - p.n_warmup);
-            #if ENERGY
-            DPU_ASSERT(dpu_probe_start(&probe));
-            #endif
-        }
+        for(unsigned int k = 0; k < n_chunks; k++) {
+            // the phase timers are reset only before the first chunk of the first timed rep
+            int t_rep = (rep - p.n_warmup) * (int)n_chunks + (int)k;
+
+            printf("Load input data\n");
+            if(rep >= p.n_warmup)
+                start(&timer, 1, t_rep);
+            // Copy input arrays
+            push_chunk(dpu_set, input_arguments + k * nr_of_dpus, bufferA, k, chunk_8bytes, input_size_dpu_8bytes, DPU_XFER_DEFAULT);
+            if(rep >= p.n_warmup)
+                stop(&timer, 1);
+
+            printf("Run program on DPU(s) \n");
+            // Run DPU kernel
+            if(rep >= p.n_warmup) {
+                start(&timer, 2, t_rep);
+                #if ENERGY
+                DPU_ASSERT(dpu_probe_start(&probe));
+                #endif
+            }
  
-        DPU_ASSERT(dpu_launch(dpu_set, DPU_SYNCHRONOUS));
-        if(rep >= p.n_warmup) {
-            stop(&timer, 2);
-            #if ENERGY
-            DPU_ASSERT(dpu_probe_stop(&probe));
-            #endif
-        }
+            DPU_ASSERT(dpu_launch(dpu_set, DPU_SYNCHRONOUS));
+            if(rep >= p.n_warmup) {
+                stop(&timer, 2);
+                #if ENERGY
+                DPU_ASSERT(dpu_probe_stop(&probe));
+                #endif
+                gather_cycles(dpu_set, dpu_cycles, nr_of_dpus, p.n_tasklets, phase_cycles);
+            }
 
 #if PRINT
-        {
-            unsigned int each_dpu = 0;
-            printf("Display DPU Logs\n");
-            DPU_FOREACH (dpu_set, dpu) {
-                printf("DPU#%d:\n", each_dpu);
-                DPU_ASSERT(dpulog_read_for_dpu(dpu.dpu, stdout));
-                each_dpu++;
+            {
+                struct dpu_set_t dpu;
+                unsigned int each_dpu = 0;
+                printf("Display DPU Logs\n");
+                DPU_FOREACH (dpu_set, dpu) {
+                    printf("DPU#%d:\n", each_dpu);
+                    DPU_ASSERT(dpulog_read_for_dpu(dpu.dpu, stdout));
+                    each_dpu++;
+                }
             }
-        }
 #endif
 
-        printf("Retrieve results\n");
-        i = 0;
-        if(rep >= p.n_warmup)
-            start(&timer, 3, rep - p.n_warmup);
-        // PARALLEL RETRIEVE TRANSFER
-        DPU_FOREACH(dpu_set, dpu, i) {
-            DPU_ASSERT(dpu_prepare_xfer(dpu, histo + p.bins * i));
+            // streaming waves keep adding to the histograms in MRAM
+            if(p.stream && k < n_chunks - 1)
+                continue;
+            if(p.stream)
+                t_rep = rep - p.n_warmup;
+
+            printf("Retrieve results\n");
+            memset(histo, 0, nr_of_dpus * p.bins * sizeof(unsigned int));
+            if(rep >= p.n_warmup)
+                start(&timer, 3, t_rep);
+            // PARALLEL RETRIEVE TRANSFER
+            pull_histograms(dpu_set, histo, p.bins, chunk_8bytes, DPU_XFER_DEFAULT);
+            if(rep >= p.n_warmup)
+                stop(&timer, 3);
+
+            // Final histogram merging
+            if(rep >= p.n_warmup)
+                start(&timer, 4, t_rep);
+            merge_histograms(histo, p.bins, nr_of_dpus);
+            for(unsigned int j = 0; j < p.bins; j++)
+                histo_sum[j] += histo[j];
+            if(rep >= p.n_warmup)
+                stop(&timer, 4);
         }
-        DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, DPU_MRAM_HEAP_POINTER_NAME, input_size_dpu_8bytes * sizeof(T), p.bins * sizeof(unsigned int), DPU_XFER_DEFAULT));
 
-        // Final histogram merging
-        for(i = 1; i < nr_of_dpus; i++){
-            for(unsigned int j = 0; j < p.bins; j++){
-                histo[j] += histo[j + i * p.bins];
-            }			
+        if(!p.async)
+            continue;
+
+        // Asynchronous pipeline: every rank works through its chunks on its
+        // own, so while one rank computes on chunk k the others are still
+        // receiving chunk k or k+1 and the host merges the histograms of the
+        // ranks that are done
+        printf("Run asynchronous pipeline\n");
+        memset(histo_rank, 0, nr_of_ranks * p.bins * sizeof(unsigned int));
+        if(rep >= p.n_warmup)
+            start(&timer, 5, rep - p.n_warmup);
+        for(unsigned int k = 0; k < n_chunks; k++) {
+            push_chunk(dpu_set, input_arguments + k * nr_of_dpus, bufferA, k, chunk_8bytes, input_size_dpu_8bytes, DPU_XFER_ASYNC);
+            DPU_ASSERT(dpu_launch(dpu_set, DPU_ASYNCHRONOUS));
+            if(p.stream && k < n_chunks - 1)
+                continue;
+            pull_histograms(dpu_set, histo, p.bins, chunk_8bytes, DPU_XFER_ASYNC);
+            DPU_ASSERT(dpu_callback(dpu_set, merge_rank, &merge_args, DPU_CALLBACK_ASYNC));
+        }
+        DPU_ASSERT(dpu_sync(dpu_set));
+        for(unsigned int j = 0; j < p.bins; j++) {
+            unsigned int b = 0;
+            for(unsigned int r = 0; r < nr_of_ranks; r++)
+                b += histo_rank[r * p.bins + j];
+            histo_pipe[j] = b;
         }
         if(rep >= p.n_warmup)
-            stop(&timer, 3);
-
+            stop(&timer, 5);
     }
 
     // Print timing results
@@ -233,9 +446,25 @@ int main(int argc, char **argv) {
     print(&timer, 2, p.n_reps);
     printf("DPU-CPU ");
     print(&timer, 3, p.n_reps);
+    printf("Merge ");
+    print(&timer, 4, p.n_reps);
+    printf("DPU-CPU+merge Time (ms): %f\t", (timer.time[3] + timer.time[4]) / (1000 * p.n_reps));
+    if(p.async) {
+        // the overlap is the share of the serialized chunk phases the
+        // pipeline hid behind each other
+        double serial = timer.time[1] + timer.time[2] + timer.time[3] + timer.time[4];
+        printf("Pipeline ");
+        print(&timer, 5, p.n_reps);
+        printf("Overlap (%%): %f\t", 100.0 * (1.0 - timer.time[5] / serial));
+    }
+
+    printf("\n");
+    printf("DPU Cycles ");
+    printf("MRAM read: %.0f\tCompute: %.0f\tMerge: %.0f\tWriteback: %.0f\t", phase_cycles[PHASE_MRAM_READ] / p.n_reps,
+        phase_cycles[PHASE_COMPUTE] / p.n_reps, phase_cycles[PHASE_MERGE] / p.n_reps, phase_cycles[PHASE_WRITEBACK] / p.n_reps);
 
+    double energy = 0;
     #if ENERGY
-    double energy;
     DPU_ASSERT(dpu_probe_get(&probe, DPU_ENERGY, DPU_AVERAGE, &energy));
     printf("DPU Energy (J): %f\t", energy);
     #endif	
@@ -244,28 +473,37 @@ int main(int argc, char **argv) {
     bool status = true;
     if(p.exp == 1) 
         for (unsigned int j = 0; j < p.bins; j++) {
-            if(histo_host[j] != histo[j]){ 
+            if(histo_host[j] != histo_sum[j]){ 
                 status = false;
 #if PRINT
-                printf("%u - %u: %u -- %u\n", j, j, histo_host[j], histo[j]);
+                printf("%u - %u: %u -- %u\n", j, j, histo_host[j], histo_sum[j]);
 #endif
             }
         }
     else if(p.exp == 2) 
         for (unsigned int j = 0; j < p.bins; j++) {
-            if(dpu_s * histo_host[j] != histo[j]){ 
+            if(dpu_s * histo_host[j] != histo_sum[j]){ 
                 status = false;
 #if PRINT
-                printf("%u - %u: %u -- %u\n", j, j, dpu_s * histo_host[j], histo[j]);
+                printf("%u - %u: %u -- %u\n", j, j, dpu_s * histo_host[j], histo_sum[j]);
 #endif
             }
         }
     else
         for (unsigned int j = 0; j < p.bins; j++) {
-            if(nr_of_dpus * histo_host[j] != histo[j]){ 
+            if(nr_of_dpus * histo_host[j] != histo_sum[j]){ 
+                status = false;
+#if PRINT
+                printf("%u - %u: %u -- %u\n", j, j, nr_of_dpus * histo_host[j], histo_sum[j]);
+#endif
+            }
+        }
+    if(p.async)
+        for (unsigned int j = 0; j < p.bins; j++) {
+            if(histo_pipe[j] != histo_sum[j]){ 
                 status = false;
 #if PRINT
-                printf("%u - %u: %u -- %u\n", j, j, nr_of_dpus * histo_host[j], histo[j]);
+                printf("%u - %u: %u -- %u\n", j, j, histo_sum[j], histo_pipe[j]);
 #endif
             }
         }
@@ -274,11 +512,20 @@ int main(int argc, char **argv) {
     } else {
         printf("[" ANSI_COLOR_RED "ERROR" ANSI_COLOR_RESET "] Outputs differ!\n");
     }
+    if (p.csv_file != NULL)
+        write_csv(p, nr_of_dpus, input_size, n_chunks, &timer, phase_cycles, energy, status);
 
     // Deallocation
     free(A);
     free(histo_host);
     free(histo);
+    free(histo_sum);
+    free(input_arguments);
+    free(rank_first_dpu);
+    free(rank_nr_dpus);
+    free(histo_rank);
+    free(histo_pipe);
+    free(dpu_cycles);
     DPU_ASSERT(dpu_free(dpu_set));
 	
     return status ? 0 : -1;
@@ -1,16 +1,17 @@
 #!/bin/bash
 
+# One build holds a DPU binary per tasklet count, the host picks it with -t
+# and allocates the DPUs with -d
+NR_DPUS=1 NR_TASKLETS=16 BL=10 SWEEP_TASKLETS="1 2 4 8 16" SWEEP_BL=10 make all
+wait
+
 for i in 1 
 do
 	for b in 64 128 256 512 1024 2048 4096
 	do
     	for k in 1 2 4 8 16
 	    do
-            NR_DPUS=$i NR_TASKLETS=$k BL=10 make all
-            wait
-            ./bin/host_code -w 2 -e 5 -b ${b} -x 1 > profile/HSTS_${b}_tl${k}_dpu${i}.txt
-            wait
-            make clean
+            ./bin/host_code -d ${i} -t ${k} -l 10 -w 2 -e 5 -b ${b} -x 1 -o profile/HSTS.csv > profile/HSTS_${b}_tl${k}_dpu${i}.txt
             wait
 		done
 	done
@@ -22,15 +22,26 @@
 
 // Structures used by both the host and the dpu to communicate information 
 typedef struct {
-    uint32_t size;
+    uint32_t size; // bytes read from MRAM, 8-byte aligned
     uint32_t transfer_size;
+    uint32_t elements; // input elements in size, the rest is padding
     uint32_t bins;
+    uint32_t accumulate; // add to the histogram already in MRAM (streaming waves)
 	enum kernels {
 	    kernel1 = 0,
 	    nr_kernels = 1,
 	} kernel;
 } dpu_arguments_t;
 
+// Phases of the DPU kernel whose cycles are recorded in DPU_CYCLES
+enum phases {
+    PHASE_MRAM_READ = 0,
+    PHASE_COMPUTE,
+    PHASE_MERGE,
+    PHASE_WRITEBACK,
+    NR_PHASES,
+};
+
 #ifndef ENERGY
 #define ENERGY 0
 #endif
@@ -40,6 +51,17 @@ typedef struct {
 #define ANSI_COLOR_GREEN   "\x1b[32m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
+// WRAM budget for the tasklet histograms, bins that do not fit are
+// histogrammed in several passes over the input
+#define HISTO_WRAM_BYTES (32 << 10)
+
+// MRAM budget for the input of one streaming wave per DPU, the histogram
+// is stored right behind it
+#define MRAM_WAVE_BYTES (56 << 20)
+
+// DPUs per rank, the first level of the host-side histogram merge
+#define DPUS_PER_RANK 64
+
 #define divceil(n, m) (((n)-1) / (m) + 1)
 #define roundup(n, m) ((n / m) * m + m)
 #endif
@@ -11,6 +11,13 @@ typedef struct Params {
     const char *file_name;
     int  exp;
     int  dpu_s;
+    unsigned int   n_chunks;
+    int  async;
+    int  stream;
+    const char *csv_file;
+    int  n_dpus;
+    int  n_tasklets;
+    int  bl;
 }Params;
 
 static void usage() {
@@ -22,11 +29,18 @@ static void usage() {
         "\n    -w <W>    # of untimed warmup iterations (default=1)"
         "\n    -e <E>    # of timed repetition iterations (default=3)"
         "\n    -x <X>    Weak (0) or strong (1, 2) scaling (default=0)"
+        "\n    -d <D>    # of DPUs, 0 allocates all available DPUs (default=NR_DPUS)"
+        "\n    -t <T>    # of tasklets of the prebuilt DPU binary (default=NR_TASKLETS)"
+        "\n    -l <L>    log2 of the block size of the prebuilt DPU binary (default=BL)"
         "\n"
         "\nBenchmark-specific options:"
         "\n    -i <I>    input size (default=1536*1024 elements)"
         "\n    -b <B>    histogram size (default=256 bins)"
         "\n    -f <F>    input image file (default=../input/image_VanHateren.iml)"
+        "\n    -c <C>    # of chunks the input of every DPU is split into (default=1)"
+        "\n    -a        also run the chunks as an asynchronous pipeline across ranks"
+        "\n    -s        stream the chunks in MRAM sized waves, the DPUs accumulate their histograms"
+        "\n    -o <O>    append the timers, DPU cycles and energy of the run as a CSV row to file O"
         "\n");
 }
 
@@ -39,9 +53,16 @@ struct Params input_params(int argc, char **argv) {
     p.exp           = 0;
     p.file_name     = "./input/image_VanHateren.iml";
     p.dpu_s         = 64;
+    p.n_chunks      = 1;
+    p.async         = 0;
+    p.stream        = 0;
+    p.csv_file      = NULL;
+    p.n_dpus        = NR_DPUS;
+    p.n_tasklets    = NR_TASKLETS;
+    p.bl            = BL;
 
     int opt;
-    while((opt = getopt(argc, argv, "hi:b:w:e:f:x:z:")) >= 0) {
+    while((opt = getopt(argc, argv, "hi:b:w:e:f:x:z:c:aso:d:t:l:")) >= 0) {
         switch(opt) {
         case 'h':
         usage();
@@ -54,13 +75,23 @@ struct Params input_params(int argc, char **argv) {
         case 'f': p.file_name     = optarg; break;
         case 'x': p.exp           = atoi(optarg); break;
         case 'z': p.dpu_s         = atoi(optarg); break;
+        case 'c': p.n_chunks      = atoi(optarg); break;
+        case 'a': p.async         = 1; break;
+        case 's': p.stream        = 1; break;
+        case 'o': p.csv_file      = optarg; break;
+        case 'd': p.n_dpus        = atoi(optarg); break;
+        case 't': p.n_tasklets    = atoi(optarg); break;
+        case 'l': p.bl            = atoi(optarg); break;
         default:
             fprintf(stderr, "\nUnrecognized option!\n");
             usage();
             exit(0);
         }
     }
-    assert(NR_DPUS > 0 && "Invalid # of dpus!");
+    assert(p.n_dpus >= 0 && "Invalid # of dpus!");
+    assert(p.n_tasklets > 0 && "Invalid # of tasklets!");
+    assert(p.n_chunks > 0 && "Invalid # of chunks!");
+    assert(p.bins % 2 == 0 && "Histograms are transferred in 8-byte units!");
 
     return p;
 }
@@ -0,0 +1,103 @@
+#ifndef HOST_PARAMS_H
+#define HOST_PARAMS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+
+// Runtime parameters of the simple-pim hosts. Every parameter starts from the
+// default in the app's Param.h, is overridden by its environment variable and
+// then by its command-line flag, so one build can be run at many sizes.
+
+typedef enum {
+    PARAM_U32,
+    PARAM_U64,
+    PARAM_FLOAT,
+    PARAM_SWITCH, // uint32_t set to 1 by a flag without value, 0/1 from the env
+} host_param_kind_t;
+
+typedef struct {
+    char opt;               // command-line flag, -<opt> <value>
+    const char* env;        // environment variable, NULL for none
+    host_param_kind_t kind;
+    void* value;            // the Param.h global to set
+    const char* help;
+} host_param_t;
+
+#define HOST_PARAMS_MAX 16
+
+static void set_host_param(const host_param_t* p, const char* s){
+    char* end;
+    switch(p->kind){
+        case PARAM_U32:
+        case PARAM_SWITCH: *(uint32_t*)p->value = (uint32_t)strtoul(s, &end, 0); break;
+        case PARAM_U64: *(uint64_t*)p->value = (uint64_t)strtoull(s, &end, 0); break;
+        case PARAM_FLOAT: *(float*)p->value = strtof(s, &end); break;
+    }
+    if(end == s || *end != '\0'){
+        fprintf(stderr, "\nInvalid value '%s' for -%c\n", s, p->opt);
+        exit(1);
+    }
+}
+
+static void print_host_param(const host_param_t* p){
+    switch(p->kind){
+        case PARAM_U32:
+        case PARAM_SWITCH: fprintf(stderr, "%u", *(uint32_t*)p->value); break;
+        case PARAM_U64: fprintf(stderr, "%lu", (unsigned long)*(uint64_t*)p->value); break;
+        case PARAM_FLOAT: fprintf(stderr, "%g", *(float*)p->value); break;
+    }
+}
+
+static void host_params_usage(const char* prog, const host_param_t* params, uint32_t n){
+    fprintf(stderr, "\nUsage:  %s [options]\n\nGeneral options:\n    -h        help\n", prog);
+    for(uint32_t i = 0; i < n; i++){
+        fprintf(stderr, params[i].kind == PARAM_SWITCH ? "    -%c        %s (default=" : "    -%c <v>    %s (default=",
+            params[i].opt, params[i].help);
+        print_host_param(&params[i]);
+        fprintf(stderr, ")");
+        if(params[i].env)
+            fprintf(stderr, " [env %s]", params[i].env);
+        fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "\n");
+}
+
+static void parse_host_params(int argc, char** argv, const host_param_t* params, uint32_t n){
+    char optstring[2*HOST_PARAMS_MAX + 2] = "h";
+    if(n > HOST_PARAMS_MAX){
+        fprintf(stderr, "\nToo many host parameters\n");
+        exit(1);
+    }
+    for(uint32_t i = 0; i < n; i++){
+        size_t len = strlen(optstring);
+        optstring[len] = params[i].opt;
+        optstring[len+1] = params[i].kind == PARAM_SWITCH ? '\0' : ':';
+        optstring[len+2] = '\0';
+    }
+
+    for(uint32_t i = 0; i < n; i++){
+        const char* s = params[i].env ? getenv(params[i].env) : NULL;
+        if(s && *s)
+            set_host_param(&params[i], s);
+    }
+
+    int opt;
+    while((opt = getopt(argc, argv, optstring)) >= 0){
+        uint32_t i = 0;
+        while(i < n && params[i].opt != opt)
+            i++;
+        if(i == n){
+            host_params_usage(argv[0], params, n);
+            exit(opt == 'h' ? 0 : 1);
+        }
+        if(params[i].kind == PARAM_SWITCH)
+            *(uint32_t*)params[i].value = 1;
+        else
+            set_host_param(&params[i], optarg);
+    }
+}
+
+#endif
@@ -14,12 +14,15 @@
 #include "processing/gen_red/GenRedArgs.h"
 
 
-void start_func(gen_red_arguments_t* args){}
+void start_func(gen_red_arguments_t* args){
+    // one table entry per bin, every tasklet stores the same value
+    bins = args->table_len;
+}
 
 void map_to_val_func(void* input, void* output, uint32_t* key){
     uint32_t d = *((uint32_t*)input);
     *(uint32_t*)output = 1;
-    *key = d*bins >> 12;
+    *key = d*bins >> DEPTH;
 }
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "processing/ProcessingHelperHost.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
 
 
 
@@ -46,6 +47,17 @@ void add(void* p1, void* p2){
     *ptr1 += *ptr2;  
 }
 
+static void input_params(int argc, char** argv){
+    host_param_t params[] = {
+        {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+        {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &nr_elements, "number of elements (0: 128 per DPU)"},
+        {'b', "SIMPLEPIM_BINS", PARAM_U32, &bins, "number of histogram bins"},
+    };
+    parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+    if(nr_elements == 0)
+        nr_elements = (uint64_t)dpu_number*128;
+}
+
 void run(){
     printf("the number of elements %lu\n", nr_elements);
     simplepim_management_t* table_management = table_management_init(dpu_number);
@@ -72,6 +84,7 @@ void run(){
 
 int main(int argc, char **argv){
     srand(17); 
+    input_params(argc, argv);
     run();
     return 0;
 }
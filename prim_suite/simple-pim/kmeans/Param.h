@@ -5,10 +5,24 @@
 #include <stdint.h>
 uint32_t print_info = 0;
 typedef int32_t T; 
-const uint32_t dpu_number = 5; // 2432
-const uint32_t k = 10;
-const uint32_t dim = 10;
-const uint64_t num_elements = 1000*dpu_number;
-const uint32_t iter = 1;
+
+// DPU distance kernel: 1 compares points and centroids as int16 after dropping
+// KMEANS_QUANT_SHIFT low bits (values past +-16383 are clamped), 0 keeps the
+// exact 32-bit distance. Both stop a centroid early once it cannot win.
+#ifndef KMEANS_INT16_DIST
+#define KMEANS_INT16_DIST 0
+#endif
+#ifndef KMEANS_QUANT_SHIFT
+#define KMEANS_QUANT_SHIFT 0
+#endif
+// defaults, overridden at run time by the host flags / SIMPLEPIM_* variables;
+// the DPU program takes k and dim from its start_func arguments
+uint32_t dpu_number = 5; // 2432
+uint32_t k = 10;
+uint32_t dim = 10;
+uint64_t num_elements = 0; // 0: 1000 elements per DPU
+uint32_t iter = 1; // upper bound when stopping at convergence
+uint32_t tolerance = 0; // converged once no centroid coordinate moves more than this
+uint32_t fixed_iter = 0; // 1: always run iter iterations, for benchmarking
 
 #endif
\ No newline at end of file
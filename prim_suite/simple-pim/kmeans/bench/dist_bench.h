@@ -0,0 +1,9 @@
+#ifndef DIST_BENCH_H
+#define DIST_BENCH_H
+
+// Points handled per mram_read by one tasklet, a multiple of 8 bytes for any
+// dim; 8 points of up to 32 int32 features leave WRAM for k=64 centroids
+#define BENCH_BLOCK_POINTS 8
+#define BENCH_MAX_DIM 32
+
+#endif
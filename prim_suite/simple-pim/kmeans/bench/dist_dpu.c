@@ -0,0 +1,57 @@
+/*
+* Cycles per point of the k-means map_to_val_func distance kernel on one DPU.
+* The points sit at the start of the MRAM heap, the k centroids right after
+* them at BENCH_ARGS.info, the same layout table_gen_red hands to start_func.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <defs.h>
+#include <mram.h>
+#include <alloc.h>
+#include <barrier.h>
+#include <perfcounter.h>
+
+#include "map_to_val_func.h"
+#include "dist_bench.h"
+
+__host gen_red_arguments_t BENCH_ARGS;
+__host uint32_t BENCH_NR_POINTS;
+__host uint64_t BENCH_CYCLES[NR_TASKLETS];
+__host uint64_t BENCH_CHECKSUM[NR_TASKLETS];
+
+BARRIER_INIT(barrier_bench, NR_TASKLETS);
+
+int main(){
+    if(me() == 0){
+        perfcounter_config(COUNT_CYCLES, true);
+    }
+    barrier_wait(&barrier_bench);
+    start_func(&BENCH_ARGS);
+
+    uint32_t point_bytes = dim*sizeof(T);
+    T* block = (T*)mem_alloc(BENCH_BLOCK_POINTS*point_bytes);
+    void* intermediate = mem_alloc(point_bytes + sizeof(int32_t));
+    uint32_t assigned[BENCH_BLOCK_POINTS];
+
+    uint64_t cycles = 0;
+    uint64_t checksum = 0;
+    // the host pads the points to whole blocks of every tasklet
+    for(uint32_t first = me()*BENCH_BLOCK_POINTS; first < BENCH_NR_POINTS; first += NR_TASKLETS*BENCH_BLOCK_POINTS){
+        mram_read((__mram_ptr void*)(DPU_MRAM_HEAP_POINTER + first*point_bytes), block, BENCH_BLOCK_POINTS*point_bytes);
+
+        perfcounter_t t0 = perfcounter_get();
+        for(uint32_t i = 0; i < BENCH_BLOCK_POINTS; i++){
+            map_to_val_func((char*)block + i*point_bytes, intermediate, &assigned[i]);
+        }
+        cycles += perfcounter_get() - t0;
+
+        // outside the timed region, folds the assignments for the host check
+        for(uint32_t i = 0; i < BENCH_BLOCK_POINTS; i++){
+            checksum += (uint64_t)(assigned[i] + 1) * (first + i + 1);
+        }
+    }
+
+    BENCH_CYCLES[me()] = cycles;
+    BENCH_CHECKSUM[me()] = checksum;
+    return 0;
+}
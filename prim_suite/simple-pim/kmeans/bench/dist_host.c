@@ -0,0 +1,136 @@
+/*
+* Sweeps the k-means DPU distance kernel over k and dim for the exact and
+* the int16 path, one DPU each, and prints the DPU cycles per point as CSV.
+* Built by `make bench`, run from the kmeans directory as ./bin/dist_host.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dpu.h>
+
+#include "processing/gen_red/GenRedArgs.h"
+#include "HostParams.h"
+#include "dist_bench.h"
+
+typedef int32_t T;
+
+#ifndef DIST_EXACT_BINARY
+#define DIST_EXACT_BINARY "./bin/dist_dpu_exact"
+#endif
+#ifndef DIST_INT16_BINARY
+#define DIST_INT16_BINARY "./bin/dist_dpu_int16"
+#endif
+
+static const uint32_t ks[] = {10, 16, 32, 64};
+static const uint32_t dims[] = {2, 4, 8, 16, 32};
+
+uint64_t nr_points = 4096;
+
+// same value range as kmeans.py, fits the int16 path without clamping
+static void init_points(T* points, uint64_t n, uint32_t dim){
+    for(uint64_t i = 0; i < n; i++){
+        for(uint32_t j = 0; j < dim; j++){
+            T v = (T)((i%100)*(10 + rand()%90) + j*(rand()%100));
+            points[i*dim+j] = i%2 == 0 ? v : -v;
+        }
+    }
+}
+
+// exact nearest centroid of every point, folded like the DPU program does
+static uint64_t reference_checksum(const T* points, const T* centroids, uint64_t n, uint32_t k, uint32_t dim){
+    uint64_t checksum = 0;
+    for(uint64_t i = 0; i < n; i++){
+        uint32_t best = 0;
+        int64_t shortest = INT64_MAX;
+        for(uint32_t c = 0; c < k; c++){
+            int64_t dist = 0;
+            for(uint32_t j = 0; j < dim; j++){
+                int64_t d = points[i*dim+j] - centroids[c*dim+j];
+                dist += d*d;
+            }
+            if(dist < shortest){
+                best = c;
+                shortest = dist;
+            }
+        }
+        checksum += (uint64_t)(best + 1) * (i + 1);
+    }
+    return checksum;
+}
+
+static double run_kernel(const char* binary, const T* points, uint64_t n, uint32_t k, uint32_t dim, uint64_t* checksum){
+    struct dpu_set_t set, dpu;
+    DPU_ASSERT(dpu_alloc(1, NULL, &set));
+    DPU_ASSERT(dpu_load(set, binary, NULL));
+
+    // points at the heap start, centroids (the first k points) right after,
+    // padded like start_func reads them
+    uint32_t points_bytes = n*dim*sizeof(T);
+    uint32_t centroids_bytes = k*dim*sizeof(T);
+    uint32_t aligned_centroids_bytes = centroids_bytes + 8 - (centroids_bytes%8);
+    T* centroids = (T*)calloc(1, aligned_centroids_bytes);
+    memcpy(centroids, points, centroids_bytes);
+    DPU_ASSERT(dpu_copy_to(set, DPU_MRAM_HEAP_POINTER_NAME, 0, points, points_bytes));
+    DPU_ASSERT(dpu_copy_to(set, DPU_MRAM_HEAP_POINTER_NAME, points_bytes, centroids, aligned_centroids_bytes));
+
+    gen_red_arguments_t args;
+    memset(&args, 0, sizeof(args));
+    args.table_len = k;
+    args.output_type_size = dim*sizeof(T) + sizeof(int32_t);
+    args.info = points_bytes;
+    uint32_t nr = n;
+    DPU_ASSERT(dpu_copy_to(set, "BENCH_ARGS", 0, &args, sizeof(args)));
+    DPU_ASSERT(dpu_copy_to(set, "BENCH_NR_POINTS", 0, &nr, sizeof(nr)));
+
+    DPU_ASSERT(dpu_launch(set, DPU_SYNCHRONOUS));
+
+    uint64_t cycles[NR_TASKLETS];
+    uint64_t checksums[NR_TASKLETS];
+    DPU_FOREACH(set, dpu){
+        DPU_ASSERT(dpu_copy_from(dpu, "BENCH_CYCLES", 0, cycles, sizeof(cycles)));
+        DPU_ASSERT(dpu_copy_from(dpu, "BENCH_CHECKSUM", 0, checksums, sizeof(checksums)));
+    }
+    DPU_ASSERT(dpu_free(set));
+    free(centroids);
+
+    // the tasklets run interleaved, the slowest one bounds the DPU time
+    uint64_t max_cycles = 0;
+    *checksum = 0;
+    for(int t = 0; t < NR_TASKLETS; t++){
+        if(cycles[t] > max_cycles){
+            max_cycles = cycles[t];
+        }
+        *checksum += checksums[t];
+    }
+    return (double)max_cycles / n;
+}
+
+int main(int argc, char** argv){
+    host_param_t params[] = {
+        {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &nr_points, "points per configuration"},
+    };
+    parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+    uint64_t whole = NR_TASKLETS*BENCH_BLOCK_POINTS;
+    nr_points = (nr_points + whole - 1) / whole * whole;
+
+    const char* binaries[] = {DIST_EXACT_BINARY, DIST_INT16_BINARY};
+    const char* names[] = {"exact", "int16"};
+
+    T* points = (T*)malloc(nr_points*BENCH_MAX_DIM*sizeof(T));
+    printf("kernel,k,dim,points,cycles_per_point,matches_exact\n");
+    for(uint32_t d = 0; d < sizeof(dims)/sizeof(dims[0]); d++){
+        srand(10);
+        init_points(points, nr_points, dims[d]);
+        for(uint32_t c = 0; c < sizeof(ks)/sizeof(ks[0]); c++){
+            uint64_t expected = reference_checksum(points, points, nr_points, ks[c], dims[d]);
+            for(int b = 0; b < 2; b++){
+                uint64_t checksum;
+                double cpp = run_kernel(binaries[b], points, nr_points, ks[c], dims[d], &checksum);
+                printf("%s,%u,%u,%lu,%.1f,%d\n", names[b], ks[c], dims[d], (unsigned long)nr_points, cpp, checksum == expected);
+            }
+        }
+    }
+    free(points);
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <dpu.h>
@@ -10,6 +11,10 @@
 #include "management/Management.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
+
+// timed per iteration: centroid broadcast, kernel + gather, average
+#define KMEANS_PHASES 3
 
 
 
@@ -52,6 +57,17 @@ void average_table_entries_to_arr(void* centroid_table, void* centroids){
   }
 }
 
+uint32_t max_centroid_shift(const T* prev, const T* curr){
+  uint32_t shift = 0;
+  for(uint32_t i=0; i<k*dim; i++){
+    uint32_t d = prev[i] > curr[i] ? prev[i]-curr[i] : curr[i]-prev[i];
+    if(d > shift){
+      shift = d;
+    }
+  }
+  return shift;
+}
+
 
 void read_csv_to_int_arr(FILE* fp, int32_t* arr, int32_t len, int32_t dim){
   if (fp == NULL) {
@@ -112,6 +128,24 @@ void get_output_file(int num_dpus, int dim, int num_elem, int k){
 
 
 
+static void input_params(int argc, char** argv){
+  host_param_t params[] = {
+    {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+    {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &num_elements, "number of elements (0: 1000 per DPU)"},
+    {'k', "SIMPLEPIM_K", PARAM_U32, &k, "number of clusters"},
+    {'m', "SIMPLEPIM_DIM", PARAM_U32, &dim, "number of features"},
+    {'i', "SIMPLEPIM_ITER", PARAM_U32, &iter, "maximum number of iterations"},
+    {'t', "SIMPLEPIM_TOL", PARAM_U32, &tolerance, "largest centroid move counted as converged"},
+    {'f', "SIMPLEPIM_FIXED_ITER", PARAM_SWITCH, &fixed_iter, "run all iterations, no convergence check"},
+    {'v', "SIMPLEPIM_PRINT_INFO", PARAM_U32, &print_info, "print per iteration times and the centroids"},
+  };
+  parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+  if(num_elements == 0)
+    num_elements = (uint64_t)dpu_number*1000;
+  // the first k points seed the centroids
+  assert(k <= num_elements);
+}
+
 void run(){
   simplepim_management_t* table_management = table_management_init(dpu_number);
   printf("k: %d, dim: %d, num_elem: %d, iter: %d \n", k, dim, num_elements, iter);
@@ -134,17 +168,81 @@ void run(){
 
   handle_t* va_handle = create_handle("kmeans_funcs", REDUCE);
 
-  simplepim_scatter("t1", elements, num_elements, dim*sizeof(T), table_management);; 
+  Timer timer;
+  start(&timer, 0, 0);
+  simplepim_scatter("t1", elements, num_elements, dim*sizeof(T), table_management);
   uint32_t data_offset = lookup_table("t1", table_management)->end;
+  // the centroids table is placed right after t1 once and then rewritten in
+  // place, the DPUs read it from data_offset
+  simplepim_broadcast("t2", centroids, k, dim*sizeof(T), table_management);
+  stop(&timer, 0);
+  // MRAM transfers are whole 8 byte words, malloc_broadcast_aligned pads for that
+  uint32_t centroids_bytes = (k*dim*sizeof(T) + 7) & ~7u;
+
+  T* prev_centroids = (T*)malloc(k*dim*sizeof(T));
+  double phase_time[KMEANS_PHASES] = {0};
+  uint32_t iters_run = 0;
+  int converged = 0;
+
   // main loop
-  for(int m=0; m<iter; m++){
-    simplepim_broadcast("t2", centroids, k, dim*sizeof(T), table_management);
-    T* res = table_gen_red("t1", "t3", dim*sizeof(T)+sizeof(int32_t), k, va_handle, table_management, data_offset);
+  start(&timer, 4, 0);
+  for(int m=0; m<iter && !converged; m++){
+    if(m > 0){
+      start(&timer, 1, 0);
+      DPU_ASSERT(dpu_broadcast_to(table_management->set, DPU_MRAM_HEAP_POINTER_NAME, data_offset, centroids, centroids_bytes, DPU_XFER_DEFAULT));
+      stop(&timer, 1);
+    } else {
+      // the first centroids went out with t2
+      timer.time[1] = 0;
+    }
 
+    start(&timer, 2, 0);
+    T* res = table_gen_red("t1", "t3", dim*sizeof(T)+sizeof(int32_t), k, va_handle, table_management, data_offset);
+    stop(&timer, 2);
 
+    start(&timer, 3, 0);
+    memcpy(prev_centroids, centroids, k*dim*sizeof(T));
     average_table_entries_to_arr(res, centroids);
-    free_table("t2", table_management);
+    if(!fixed_iter)
+      converged = max_centroid_shift(prev_centroids, centroids) <= tolerance;
+    stop(&timer, 3);
+    free(res);
 
+    for(int p=0; p<KMEANS_PHASES; p++){
+      phase_time[p] += timer.time[p+1];
+    }
+    iters_run++;
+
+    if(print_info){
+      printf("iteration %d: broadcast %f ms, kernel+gather %f ms, average %f ms\n", m,
+        timer.time[1]/1000, timer.time[2]/1000, timer.time[3]/1000);
+    }
+  }
+  stop(&timer, 4);
+
+  if(converged){
+    printf("converged after %u iterations \n", iters_run);
+  } else {
+    printf("stopped after %u iterations without converging \n", iters_run);
+  }
+
+  printf("the total time of the iterations (ms): ");
+  print(&timer, 4, 1);
+  printf("\n");
+  printf("initial CPU-DPU input transfer (ms): ");
+  print(&timer, 0, 1);
+  printf("\n");
+  // iteration 0 reuses the centroids t2 went out with, only the later
+  // iterations broadcast
+  if(iters_run > 1){
+    printf("CPU-DPU centroid broadcast per iteration (ms): %f\n", phase_time[0]/(1000*(iters_run-1)));
+  }
+  if(iters_run > 0){
+    printf("DPU Kernel+DPU-CPU Time per iteration (ms): %f\n", phase_time[1]/(1000*iters_run));
+    printf("CPU average Time per iteration (ms): %f\n", phase_time[2]/(1000*iters_run));
+  }
+
+  if(print_info){
     for(int i=0; i<k; i++){
       for(int j=0; j<dim; j++){
         printf("%d ", centroids[i*dim+j]);
@@ -153,12 +251,12 @@ void run(){
     }
   }
 
-  
-  
+  free(prev_centroids);
 }
 
 
 int main(int argc, char **argv){
+  input_params(argc, argv);
   run();
   return 0;
 }
@@ -15,16 +15,47 @@
 
 __dma_aligned void* centroids_data;
 
+#if KMEANS_INT16_DIST
+// |a-b| of two quantized values stays within int16, so every square is a
+// 16x16 multiply instead of a 32x32 one on the DPU's 8x8 multiplier
+#define KMEANS_Q_MAX 16383
+int16_t* centroids_q;
+int16_t* points_q; // the current point of each tasklet, dim values each
+
+static inline int16_t quantize(T v){
+    int32_t q = v >> KMEANS_QUANT_SHIFT;
+    if(q > KMEANS_Q_MAX){
+        q = KMEANS_Q_MAX;
+    } else if(q < -KMEANS_Q_MAX){
+        q = -KMEANS_Q_MAX;
+    }
+    return (int16_t)q;
+}
+#endif
+
 
 BARRIER_INIT(barrier_maptoval, NR_TASKLETS);
 void start_func(gen_red_arguments_t* args){
-    uint32_t total_len = args->table_len * args->output_type_size;
-    uint32_t aligned_weights_size = total_len + 8-(total_len%8);
     if(me()==0){
-        // initialise weights
-        fsb_allocator_t weights_allocator = fsb_alloc(aligned_weights_size, 1);
+        // sizes come from the table shape: k entries of (count, dim values)
+        k = args->table_len;
+        dim = (args->output_type_size - sizeof(int32_t)) / sizeof(T);
+        // the broadcast centroids are k*dim values, read within the 2048 byte DMA limit
+        uint32_t centroids_len = k * dim * sizeof(T);
+        uint32_t aligned_centroids_size = (centroids_len + 7) & ~7u;
+        fsb_allocator_t weights_allocator = fsb_alloc(aligned_centroids_size, 1);
         centroids_data = (void*)fsb_get(weights_allocator);
-        mram_read(DPU_MRAM_HEAP_POINTER+args->info, centroids_data, aligned_weights_size);
+        for(uint32_t off=0; off<aligned_centroids_size; off+=2048){
+            uint32_t len = aligned_centroids_size-off < 2048 ? aligned_centroids_size-off : 2048;
+            mram_read(DPU_MRAM_HEAP_POINTER+args->info+off, (char*)centroids_data+off, len);
+        }
+#if KMEANS_INT16_DIST
+        centroids_q = (int16_t*)mem_alloc(k*dim*sizeof(int16_t));
+        points_q = (int16_t*)mem_alloc(NR_TASKLETS*dim*sizeof(int16_t));
+        for(int i=0; i<k*dim; i++){
+            centroids_q[i] = quantize(((T*)centroids_data)[i]);
+        }
+#endif
     }
     barrier_wait(&barrier_maptoval);
 }
@@ -37,18 +68,44 @@ void map_to_val_func(void* input_point, void* intermediate_input, uint32_t* cent
 
     T* intermediate_ptr = (T*)intermediate_input;
     T* input_point_ptr = (T*)input_point;
-    T* centroids_data_ptr = (T*)centroids_data;
     
+    // find the right centroid
+    uint32_t curr_best_centroid = 0;
+    uint64_t curr_dist;
+    uint64_t shortest_dist =  UINT64_MAX;
+
+#if KMEANS_INT16_DIST
+    int16_t* point_q = points_q + me()*dim;
     for(int i=0; i<dim; i++){
         intermediate_ptr[i] = input_point_ptr[i];
+        point_q[i] = quantize(input_point_ptr[i]);
     }
 
-    // find the right centroid
+    const int16_t* centroid_q = centroids_q;
+    int16_t d;
+    for(int i=0; i<k; i++, centroid_q+=dim){
+        curr_dist = 0;
+        for(int j=0; j<dim; j++){
+            d = point_q[j]-centroid_q[j];
+            curr_dist += (uint32_t)(d*d);
+            // partial sums only grow, this centroid can no longer win
+            if(curr_dist>=shortest_dist){
+                break;
+            }
+        }
+        if(curr_dist<shortest_dist){
+            curr_best_centroid = i;
+            shortest_dist = curr_dist;
+        }
+    }
+#else
+    for(int i=0; i<dim; i++){
+        intermediate_ptr[i] = input_point_ptr[i];
+    }
+
+    T* centroids_data_ptr = (T*)centroids_data;
     uint32_t curr_centroid_pos;
-    uint32_t curr_best_centroid;
     T tmp;
-    uint64_t curr_dist;
-    uint64_t shortest_dist =  UINT64_MAX;
 
     for(int i=0; i<k; i++){
         curr_centroid_pos = i*dim;
@@ -56,12 +113,17 @@ void map_to_val_func(void* input_point, void* intermediate_input, uint32_t* cent
         for(int j=0; j<dim; j++){
             tmp = input_point_ptr[j]-centroids_data_ptr[curr_centroid_pos+j];
             curr_dist += tmp*tmp;
+            // partial sums only grow, this centroid can no longer win
+            if(curr_dist>=shortest_dist){
+                break;
+            }
         }
         if(curr_dist<shortest_dist){
             curr_best_centroid = i; 
             shortest_dist = curr_dist;
         }
     }
+#endif
 
     *centroid = curr_best_centroid;
 }
@@ -11,6 +11,7 @@
 #include "management/Management.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
 
 FILE* fp;
 
@@ -48,52 +49,64 @@ void write_time_to_csv(double* arr, int32_t len){
     fclose(fp);
 }
 
-void compute_gradients(const T*arr){
+// timed per iteration: gradient gen_red (kernel + gather), weight update,
+// weight broadcast
+#define TRAIN_PHASES 3
 
-  // [X|Y] -> [X], [Y]
-  T* X = malloc(num_elements*dim*sizeof(T));
-  T* Y = malloc(num_elements*sizeof(T));
-  for(uint32_t i=0; i<num_elements; i++){
-    for(uint32_t j=0; j<dim; j++){
-      X[i*dim+j] = arr[i*(dim+1)+j];
-    }
-    Y[i] = arr[i*(dim+1)+dim];
+// One pass of the DPU gradient over [X|Y] rows with the same fixed-point
+// arithmetic as lin_reg_funcs, so the sums match the DPUs exactly
+void compute_gradients(const T* arr, const T* weights, int64_t* gradient_tmp){
+  int64_t dot_product; 
+  int64_t e;
+  for (uint32_t n = 0; n < dim; ++n) {
+    gradient_tmp[n] = 0;
   }
 
-  // actual code
-  T* weights = malloc(dim*sizeof(T));
-
-  for (uint32_t n = 0; n < dim; n++) {
-    weights[n] = 0;
-  }
+  for (uint32_t j = 0; j < num_elements; ++j) {
+    const T* x = arr + j*(dim+1);
+    dot_product = 0; 
+    for (uint32_t k = 0; k < dim; k++) {
+      dot_product += x[k] * weights[k]; 
+    }
 
-  int64_t dot_product; 
-  int64_t e;
-  int64_t* gradient_tmp = (int64_t*) calloc(dim, sizeof(int64_t)); 
-  for (uint32_t i = 0; i < iter; ++i){
-    for (uint32_t n = 0; n < dim; ++n) {
-      gradient_tmp[i] = 0;
+    e = dot_product-(x[dim]<<shift_amount);
+    for (uint32_t l = 0; l < dim; l++) {
+      gradient_tmp[l] += x[l] * e >> prevent_overflow_shift_amount; 
     }
+  }
+}
 
-    for (uint32_t j = 0; j < num_elements; ++j) {
-        dot_product = 0; 
-        for (uint32_t k = 0; k < dim; k++) {
-          dot_product += X[j*dim + k] * weights[k]; 
-        }
+// Gradient step of the mean squared error. The weights are fixed point with
+// shift_amount fraction bits; weights_float keeps them unrounded so small
+// steps accumulate, the DPUs get them rounded to T.
+void update_weights(float* weights_float, T* weights, const int64_t* gradients){
+  const float step = 2.0f * lr * (float)(1 << prevent_overflow_shift_amount) / num_elements;
+  #pragma omp simd
+  for (uint32_t i = 0; i < dim; i++) {
+    weights_float[i] -= step * (float)gradients[i];
+    weights[i] = (T)(weights_float[i] + (weights_float[i] < 0 ? -0.5f : 0.5f));
+  }
+}
 
-        e = dot_product-(Y[j]<<shift_amount);
-        for (uint32_t l = 0; l < dim; l++) {
-                gradient_tmp[l] += X[j*dim + l] * e >> prevent_overflow_shift_amount; 
-        }
-    }
+// CPU reference of the whole training loop, returns its time in ms
+double train_host(const T* arr, T* weights, uint32_t iters){
+  Timer timer;
+  float* weights_float = calloc(dim, sizeof(float));
+  int64_t* gradient_tmp = (int64_t*) calloc(dim, sizeof(int64_t)); 
+  for (uint32_t n = 0; n < dim; n++) {
+    weights[n] = 0;
   }
 
-  printf("\nthe gradients on host: \n");
-  for(int i=0; i<dim; i++){
-    printf("%lld ", gradient_tmp[i]);
+  start(&timer, 0, 0);
+  for (uint32_t i = 0; i < iters; ++i){
+    compute_gradients(arr, weights, gradient_tmp);
+    update_weights(weights_float, weights, gradient_tmp);
   }
-  printf("\n");
+  stop(&timer, 0);
 
+  free(weights_float);
+  free(gradient_tmp);
+  return timer.time[0] / 1000;
 }
 
 void get_output_file(int num_dpus, int dim, int num_elem){
@@ -114,30 +127,24 @@ void get_output_file(int num_dpus, int dim, int num_elem){
 
 
 
-int main(){
+static void input_params(int argc, char** argv){
+  host_param_t params[] = {
+    {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+    {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &num_elements, "number of elements (0: 1000 per DPU)"},
+    {'m', "SIMPLEPIM_DIM", PARAM_U32, &dim, "number of features"},
+    {'i', "SIMPLEPIM_ITER", PARAM_U32, &iter, "number of iterations"},
+    {'l', "SIMPLEPIM_LR", PARAM_FLOAT, &lr, "learning rate"},
+    {'v', "SIMPLEPIM_PRINT_INFO", PARAM_U32, &print_info, "print extra info and the DPU logs"},
+  };
+  parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+  if(num_elements == 0)
+    num_elements = (uint64_t)dpu_number*1000;
+}
+
+int main(int argc, char **argv){
+  input_params(argc, argv);
   simplepim_management_t* table_management = table_management_init(dpu_number);
   printf("dim: %d, num_elem: %d, iter: %d, lr: %f \n", dim, num_elements, iter, lr);
-
-  // reading arguments 
-  /*
-  fp = fopen ("data/args.csv", "r");
-  if (fp == NULL) {
-        fprintf(stderr, "Error reading file\n");
-        return -1;
-  }
-  else{
-    float tmp;
-
-    fscanf(fp, "%f", &tmp);
-    dim = (int)tmp;
-    fscanf(fp, "%f", &tmp);
-    num_elements = (int)tmp;
-    fscanf(fp, "%f", &tmp);
-    iter = (int)tmp;
-    fscanf(fp, "%f", &lr);
-  }
-  fclose(fp);
-  */
   // data contains y also as last element
 
 
@@ -150,13 +157,11 @@ int main(){
   
   // weights data
   T* weights = malloc_broadcast_aligned(1, sizeof(T)*dim, table_management);
-  float* weights_float = malloc_broadcast_aligned(1, sizeof(T)*dim, table_management);
+  float* weights_float = calloc(dim, sizeof(float));
   for(int i=0; i<dim; i++){
       weights[i] = 0;
   }
-
-  int64_t* gradients_dpu = malloc(dim*sizeof(T));
-  compute_gradients(elements);
+  int64_t* gradients_dpu = malloc(dim*sizeof(int64_t));
 
   if(print_info){
     printf("initial weight data \n");
@@ -166,134 +171,85 @@ int main(){
     printf("\n");
   }
   printf("end of reading data from file\n");
+
+  Timer timer;
+  start(&timer, 0, 0);
   simplepim_scatter("t1", elements, num_elements, (dim+1)*sizeof(T), table_management);
   uint32_t data_offset = lookup_table("t1", table_management)->end; 
+  // t2 is placed right after t1 once and rewritten in place every iteration,
+  // the DPUs read the weights from data_offset
   simplepim_broadcast("t2", weights, 1, dim*sizeof(T),  table_management);
-  uint32_t weights_offset = lookup_table("t2", table_management)->end; 
+  stop(&timer, 0);
+  // MRAM transfers are whole 8 byte words, malloc_broadcast_aligned pads for that
+  uint32_t weights_bytes = (dim*sizeof(T) + 7) & ~7u;
 
   handle_t* va_handle = create_handle("lin_reg_funcs", REDUCE);
 
+  double phase_time[TRAIN_PHASES] = {0};
+  start(&timer, 4, 0);
   for(int l=0; l<iter; l++){
+    start(&timer, 1, 0);
     int64_t* res = table_gen_red("t1", "t3",  dim*sizeof(int64_t), 1, va_handle, table_management, data_offset);
-
-    //free_table("t2", table_management);
-    //free_table("t3", table_management);
-    simplepim_broadcast("t2", weights, 1, dim*sizeof(T), table_management);
-
-    for(int i=0; i<dim; i++){
-      gradients_dpu[i] = res[i];
-    }
-    free(res);
-  }
-
-  
-  printf("the gradients of linear model: \n");
-  for(int i=0; i<dim; i++){
-    printf("%lld ", gradients_dpu[i]);
-  }
-  printf("\n");
-  
-
-  /*
-
-  // preparing and parsing argument
-  dpu_arguments_t* input_args = (dpu_arguments_t*) malloc(num_dpus * sizeof(dpu_arguments_t));
-
-  for(int i=0; i<num_dpus; i++){
-     input_args[i].input_start_offset = 0;
-     input_args[i].input_type_size = dim*sizeof(T);
-     input_args[i].data_start_offset = data_offset;
-     input_args[i].data_len = 1;
-     input_args[i].data_type_size = X_dim*sizeof(T);
-     input_args[i].end_offset = end_offset;
-     input_args[i].table_type_size = X_dim*sizeof(T);
-     input_args[i].table_len = 1;
-  }
-
-
-  prepare_input_len_and_parse_args(set, input_args, num_elements, dim*sizeof(T), num_dpus);
-  stop(&timer, 0);
-  //printf("end of parsing arguments to upmem\n");
-
-  // launch actual dpu code
-  T* grads_table = (T*)malloc(sizeof(T)*X_dim);
-  for(int it=0; it<iter; it++){
-    start(&timer, 1, it);
-    DPU_ASSERT(dpu_launch(set, DPU_SYNCHRONOUS));
     stop(&timer, 1);
+    memcpy(gradients_dpu, res, dim*sizeof(int64_t));
+    free(res);
 
-    if(print_info){
-      DPU_FOREACH(set, dpu) {
-        DPU_ASSERT(dpu_log_read(dpu, stdout));
-      }
-    }
-
-    start(&timer, 2, it);
-    gather_tables_to_host(set, grads_table, 1, X_dim*sizeof(T), end_offset, num_dpus, zero_init, add);
+    start(&timer, 2, 0);
+    update_weights(weights_float, weights, gradients_dpu);
     stop(&timer, 2);
 
-    start(&timer, 3, it);
-    for(int i=0; i<X_dim; i++){
-      grads_table[i] *= 2;
-      grads_table[i] /= num_elements;
-      //printf("%f ", grads_table[i]);
-    }
-    //printf("\n");
-
-    //update gradients
-    for(int i=0; i<X_dim; i++){
-        weights[i] -= lr * grads_table[i];
-    }
+    start(&timer, 3, 0);
+    DPU_ASSERT(dpu_broadcast_to(table_management->set, DPU_MRAM_HEAP_POINTER_NAME, data_offset, weights, weights_bytes, DPU_XFER_DEFAULT));
     stop(&timer, 3);
 
-    start(&timer, 4, it);
-    host_broadcast_to_dpu(set, weights, 1, X_dim*sizeof(T), data_offset);
-    stop(&timer, 4);
+    for(int p=0; p<TRAIN_PHASES; p++){
+      phase_time[p] += timer.time[p+1];
+    }
+    if(print_info){
+      printf("iteration %d: kernel+gather %f ms, update %f ms, broadcast %f ms\n", l,
+        timer.time[1]/1000, timer.time[2]/1000, timer.time[3]/1000);
+    }
   }
-  stop(&timer, 5);
+  stop(&timer, 4);
 
-  printf("the total time with timing consumed is (ms): ");
-  print(&timer, 5, 1);
+  printf("the total time of the iterations (ms): ");
+  print(&timer, 4, 1);
   printf("\n");
   printf("initial CPU-DPU input transfer (ms): ");
-	print(&timer, 0, 1);
-  printf("\n");
-	printf("DPU Kernel Time (ms): ");
-	print(&timer, 1, iter);
-  printf("\n");
-	printf("DPU-CPU Time (ms): ");
-	print(&timer, 2, iter);
-  printf("\n");
-	printf("CPU combine table Time (ms): ");
-	print(&timer, 3, iter);
+  print(&timer, 0, 1);
   printf("\n");
-	printf("CPU-DPU Time (ms): ");
-	print(&timer, 4, iter);
-  printf("\n");
-
-  float total_time = timer.time[0];
-  for(int i=1; i<5; i++){
-    total_time += timer.time[i];
+  if(iter > 0){
+    printf("DPU Kernel+DPU-CPU Time per iteration (ms): %f\n", phase_time[0]/(1000*iter));
+    printf("CPU weight update Time per iteration (ms): %f\n", phase_time[1]/(1000*iter));
+    printf("CPU-DPU weight broadcast per iteration (ms): %f\n", phase_time[2]/(1000*iter));
+    printf("DPU epochs per second: %f\n", iter/(timer.time[4]/1000000));
   }
-  
-  printf("total time added up (ms): %f\n", total_time/1000);
+
+  T* weights_host = malloc(dim*sizeof(T));
+  double host_ms = train_host(elements, weights_host, iter);
+  if(iter > 0)
+    printf("CPU epochs per second: %f\n", iter/(host_ms/1000));
 
   printf("the weights of linear model: \n");
-  for(int i=0; i<X_dim; i++){
-    printf("%f ", weights[i]);
+  for(int i=0; i<dim; i++){
+    printf("%d ", weights[i]);
   }
   printf("\n");
 
-  double* times = (double*)malloc(sizeof(double)*6);
-  for(int i=0; i<5; i++){
-    times[i] = timer.time[i];
+  int32_t is_correct = 1;
+  for(int i=0; i<dim; i++){
+    if(weights[i] != weights_host[i]){
+      is_correct = 0;
+      printf("weight mismatch at position %d, got %d, expected %d \n", i, weights[i], weights_host[i]);
+      break;
+    }
+  }
+  if(is_correct){
+    printf("the result is correct \n");
   }
-  times[5] = total_time;
-  get_output_file(num_dpus, X_dim, num_elements);
-  write_time_to_csv(times, 6);
-
 
-  free(grads_table);
-  */
+  free(weights_host);
+  free(weights_float);
+  free(gradients_dpu);
   return 0;
 }
@@ -21,6 +21,8 @@ void start_func(gen_red_arguments_t* args){
     uint32_t total_len = args->table_len * args->output_type_size;
     uint32_t aligned_weights_size = total_len + 8-(total_len%8);
     if(me()==0){
+        // one entry of dim int64 gradients
+        dim = args->output_type_size / sizeof(int64_t);
         // initialise weights
         fsb_allocator_t weights_allocator = fsb_alloc(aligned_weights_size, 1);
         weights_data = (void*)fsb_get(weights_allocator);
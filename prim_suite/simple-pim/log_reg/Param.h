@@ -5,11 +5,13 @@
 #include <stdint.h>
 uint32_t print_info = 0;
 typedef int T; 
-const uint32_t dpu_number = 5; // 2432
-const uint32_t dim = 10;
-const uint64_t num_elements = 1000*dpu_number;
-const uint32_t iter = 1;
-const float lr = 1e-4;
+// defaults, overridden at run time by the host flags / SIMPLEPIM_* variables;
+// the DPU program takes dim from its start_func arguments
+uint32_t dpu_number = 5; // 2432
+uint32_t dim = 10;
+uint64_t num_elements = 0; // 0: 1000 elements per DPU
+uint32_t iter = 1;
+float lr = 1e-4;
 const uint32_t prevent_overflow_shift_amount = 3;
 const uint32_t shift_amount = 5;
 #endif
@@ -12,6 +12,7 @@
 #include "management/Management.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
 
 
 
@@ -119,7 +120,22 @@ void compute_gradients(const T*arr){
 
 
 
-int main(){
+static void input_params(int argc, char** argv){
+  host_param_t params[] = {
+    {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+    {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &num_elements, "number of elements (0: 1000 per DPU)"},
+    {'m', "SIMPLEPIM_DIM", PARAM_U32, &dim, "number of features"},
+    {'i', "SIMPLEPIM_ITER", PARAM_U32, &iter, "number of iterations"},
+    {'l', "SIMPLEPIM_LR", PARAM_FLOAT, &lr, "learning rate"},
+    {'v', "SIMPLEPIM_PRINT_INFO", PARAM_U32, &print_info, "print extra info and the DPU logs"},
+  };
+  parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+  if(num_elements == 0)
+    num_elements = (uint64_t)dpu_number*1000;
+}
+
+int main(int argc, char **argv){
+  input_params(argc, argv);
   simplepim_management_t* table_management = table_management_init(dpu_number);
 
   printf("dim: %d, num_elem: %d, iter: %d, lr: %f \n", dim, num_elements, iter, lr);
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dpu.h>
+
+#include "Map2.h"
+#include "Map2Args.h"
+
+void table_map2(const char* src1_name, const char* src2_name, const char* dest_name, uint32_t output_type,
+    const char* binary, simplepim_management_t* table_management, uint32_t info){
+    table_map2_fused(src1_name, src2_name, dest_name, output_type, MAP2_WRITE_OUTPUT, 0, NULL, NULL,
+        binary, table_management, info);
+}
+
+void table_map2_fused(const char* src1_name, const char* src2_name, const char* dest_name, uint32_t output_type,
+    uint32_t flags, uint32_t reduce_type, void* reduce_res, void (*combine)(void*, void*),
+    const char* binary, simplepim_management_t* table_management, uint32_t info){
+    table_host_t* src1 = lookup_table(src1_name, table_management);
+    table_host_t* src2 = lookup_table(src2_name, table_management);
+    assert(src1->len == src2->len && "binary map over tables of different lengths");
+    assert((dest_name != NULL) == ((flags & MAP2_WRITE_OUTPUT) != 0) && "an output table needs MAP2_WRITE_OUTPUT");
+    assert(reduce_type <= MAP2_REDUCE_MAX_BYTES && "reduction value too large");
+
+    uint32_t num_dpus = table_management->num_dpus;
+    struct dpu_set_t set = table_management->set, dpu;
+
+    // the output table goes to the free MRAM behind the existing tables, its
+    // size is rounded up to the 8 bytes the DPUs write in; the per DPU
+    // reduction values are only scratch space behind it
+    uint32_t max_len = 0;
+    for(uint32_t i=0; i<num_dpus; i++){
+        if(src1->lens[i] > max_len){
+            max_len = src1->lens[i];
+        }
+    }
+    uint32_t output_start = table_management->free_space_start_pos;
+    uint32_t output_bytes = (flags & MAP2_WRITE_OUTPUT) ? (max_len * output_type + 7) & ~7u : 0;
+    uint32_t reduce_start = output_start + output_bytes;
+    uint32_t reduce_bytes = (reduce_type + 7) & ~7u;
+
+    map2_arguments_t* input_args = (map2_arguments_t*)malloc(num_dpus * sizeof(map2_arguments_t));
+    for(uint32_t i=0; i<num_dpus; i++){
+        input_args[i].input1_start_offset = src1->start;
+        input_args[i].input1_type_size = src1->table_type_size;
+        input_args[i].input2_start_offset = src2->start;
+        input_args[i].input2_type_size = src2->table_type_size;
+        input_args[i].output_start_offset = output_start;
+        input_args[i].output_type_size = output_type;
+        input_args[i].len = src1->lens[i];
+        input_args[i].info = info;
+        input_args[i].flags = flags;
+        input_args[i].reduce_start_offset = reduce_start;
+        input_args[i].reduce_type_size = reduce_type;
+        input_args[i].padding = 0;
+    }
+
+    uint32_t i = 0;
+    DPU_ASSERT(dpu_load(set, binary, NULL));
+    // a stage the binary was built without would silently do nothing
+    uint32_t supported = 0;
+    DPU_FOREACH(set, dpu){
+        DPU_ASSERT(dpu_copy_from(dpu, "MAP2_SUPPORTED_FLAGS", 0, &supported, sizeof(supported)));
+        break;
+    }
+    assert(!(flags & ~supported) && "the DPU binary was built without a requested stage, see its map.h");
+    DPU_FOREACH(set, dpu, i){
+        DPU_ASSERT(dpu_prepare_xfer(dpu, &input_args[i]));
+    }
+    DPU_ASSERT(dpu_push_xfer(set, DPU_XFER_TO_DPU, "MAP2_INPUT_ARGUMENTS", 0, sizeof(map2_arguments_t), DPU_XFER_DEFAULT));
+    DPU_ASSERT(dpu_launch(set, DPU_SYNCHRONOUS));
+    free(input_args);
+
+    // the reduction is the only thing that comes back to the host
+    if(flags & MAP2_REDUCE){
+        char* partial = (char*)malloc(num_dpus * reduce_bytes);
+        DPU_FOREACH(set, dpu, i){
+            DPU_ASSERT(dpu_prepare_xfer(dpu, partial + i * reduce_bytes));
+        }
+        DPU_ASSERT(dpu_push_xfer(set, DPU_XFER_FROM_DPU, DPU_MRAM_HEAP_POINTER_NAME, reduce_start, reduce_bytes, DPU_XFER_DEFAULT));
+        memcpy(reduce_res, partial, reduce_type);
+        for(i=1; i<num_dpus; i++){
+            combine(reduce_res, partial + i * reduce_bytes);
+        }
+        free(partial);
+    }
+
+    if(!(flags & MAP2_WRITE_OUTPUT)){
+        return;
+    }
+
+    // register the output so it can be gathered or mapped like any table
+    table_host_t* dest = (table_host_t*)calloc(1, sizeof(table_host_t));
+    dest->name = (char*)malloc(strlen(dest_name) + 1);
+    strcpy(dest->name, dest_name);
+    dest->start = output_start;
+    dest->end = output_start + output_bytes;
+    dest->len = src1->len;
+    dest->table_type_size = output_type;
+    dest->lens = (uint32_t*)malloc(num_dpus * sizeof(uint32_t));
+    memcpy(dest->lens, src1->lens, num_dpus * sizeof(uint32_t));
+    add_table(dest, table_management);
+    if(table_management->free_space_start_pos < dest->end){
+        table_management->free_space_start_pos = dest->end;
+    }
+}
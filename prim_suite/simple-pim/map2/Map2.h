@@ -0,0 +1,27 @@
+#ifndef MAP2_H
+#define MAP2_H
+
+#include <stdint.h>
+#include "management/Management.h"
+#include "Map2Args.h"
+
+// Binary map: dest[i] = map_func(src1[i], src2[i]) on every DPU. Both
+// tables are streamed from MRAM as they are, so unlike table_zip followed by
+// table_map no interleaved copy of the inputs is materialized. src1 and src2
+// must be scattered with the same length and thus the same split over the
+// DPUs. binary is the DPU program built from Map2Processing.c and the user
+// functions, info is passed on to start_func.
+void table_map2(const char* src1_name, const char* src2_name, const char* dest_name, uint32_t output_type,
+    const char* binary, simplepim_management_t* table_management, uint32_t info);
+
+// Lazy pipeline: map_func, then map_chain_func in place with MAP2_CHAIN,
+// then reduce_func with MAP2_REDUCE, all fused into one DPU launch. Only a
+// dest_name other than NULL keeps the map results resident as a table; the
+// reduction gathers one reduce_type sized value per DPU, folded into
+// reduce_res with combine. The user functions must define MAP2_CHAIN_FUNC
+// and MAP2_REDUCE_FUNC for the stages they provide.
+void table_map2_fused(const char* src1_name, const char* src2_name, const char* dest_name, uint32_t output_type,
+    uint32_t flags, uint32_t reduce_type, void* reduce_res, void (*combine)(void*, void*),
+    const char* binary, simplepim_management_t* table_management, uint32_t info);
+
+#endif
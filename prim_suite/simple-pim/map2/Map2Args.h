@@ -0,0 +1,33 @@
+#ifndef MAP2_ARGS_H
+#define MAP2_ARGS_H
+
+#include <stdint.h>
+
+// Stages of a fused binary map launch
+enum map2_flags {
+    MAP2_WRITE_OUTPUT = 1, // write the map results to the output table
+    MAP2_CHAIN = 2,        // apply map_chain_func to every map result in place
+    MAP2_REDUCE = 4,       // reduce the map results with reduce_func
+};
+
+// Largest reduction value a fused launch supports
+#define MAP2_REDUCE_MAX_BYTES 64
+
+// Arguments of one DPU for a binary map, offsets are relative to
+// DPU_MRAM_HEAP_POINTER like the ones of the SimplePIM tables
+typedef struct {
+    uint32_t input1_start_offset;
+    uint32_t input1_type_size;
+    uint32_t input2_start_offset;
+    uint32_t input2_type_size;
+    uint32_t output_start_offset;
+    uint32_t output_type_size;
+    uint32_t len;
+    uint32_t info;
+    uint32_t flags;
+    uint32_t reduce_start_offset;
+    uint32_t reduce_type_size;
+    uint32_t padding;
+} map2_arguments_t;
+
+#endif
@@ -0,0 +1,113 @@
+/*
+* Binary map, every tasklet streams blocks of both input tables from MRAM
+* and applies the user map_func element by element. A fused launch also runs
+* map_chain_func on every result and reduces the results with reduce_func.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <defs.h>
+#include <mram.h>
+#include <alloc.h>
+#include <barrier.h>
+
+#include "Map2Args.h"
+#include "map.h"
+
+// Elements per block, a multiple of 8 keeps every block 8-byte aligned in
+// MRAM whatever the type sizes are; types up to 32 bytes keep a block within
+// the 2048 bytes of one MRAM transfer
+#ifndef MAP2_BLOCK_ELEMS
+#define MAP2_BLOCK_ELEMS 64
+#endif
+
+__host map2_arguments_t MAP2_INPUT_ARGUMENTS;
+
+// Stages this binary was built with, the host checks the requested ones
+// against it before launching
+#ifdef MAP2_CHAIN_FUNC
+#define MAP2_CHAIN_SUPPORTED MAP2_CHAIN
+#else
+#define MAP2_CHAIN_SUPPORTED 0
+#endif
+#ifdef MAP2_REDUCE_FUNC
+#define MAP2_REDUCE_SUPPORTED MAP2_REDUCE
+#else
+#define MAP2_REDUCE_SUPPORTED 0
+#endif
+__host uint32_t MAP2_SUPPORTED_FLAGS = MAP2_WRITE_OUTPUT | MAP2_CHAIN_SUPPORTED | MAP2_REDUCE_SUPPORTED;
+
+BARRIER_INIT(map2_barrier, NR_TASKLETS);
+
+#ifdef MAP2_REDUCE_FUNC
+// Reduction value of every tasklet
+uint64_t reduce_acc[NR_TASKLETS][MAP2_REDUCE_MAX_BYTES / sizeof(uint64_t)];
+#endif
+
+#define ALIGN8(n) (((n) + 7) & ~7u)
+
+int main(){
+    uint32_t tasklet_id = me();
+    if(tasklet_id == 0){
+        mem_reset();
+    }
+    barrier_wait(&map2_barrier);
+
+    map2_arguments_t* args = &MAP2_INPUT_ARGUMENTS;
+    start_func(args);
+
+    uint32_t in1_size = args->input1_type_size;
+    uint32_t in2_size = args->input2_type_size;
+    uint32_t out_size = args->output_type_size;
+    uint32_t len = args->len;
+
+    char* in1 = (char*)mem_alloc(MAP2_BLOCK_ELEMS * in1_size);
+    char* in2 = (char*)mem_alloc(MAP2_BLOCK_ELEMS * in2_size);
+    char* out = (char*)mem_alloc(MAP2_BLOCK_ELEMS * out_size);
+    uint32_t flags = args->flags;
+#ifdef MAP2_REDUCE_FUNC
+    void* acc = reduce_acc[tasklet_id];
+    if(flags & MAP2_REDUCE){
+        reduce_init_func(acc);
+    }
+#endif
+
+    for(uint32_t block = tasklet_id * MAP2_BLOCK_ELEMS; block < len; block += NR_TASKLETS * MAP2_BLOCK_ELEMS){
+        uint32_t l_elems = len - block < MAP2_BLOCK_ELEMS ? len - block : MAP2_BLOCK_ELEMS;
+
+        mram_read((__mram_ptr void const*)(DPU_MRAM_HEAP_POINTER + args->input1_start_offset + block * in1_size), in1, ALIGN8(l_elems * in1_size));
+        mram_read((__mram_ptr void const*)(DPU_MRAM_HEAP_POINTER + args->input2_start_offset + block * in2_size), in2, ALIGN8(l_elems * in2_size));
+
+        for(uint32_t j = 0; j < l_elems; j++){
+            map_func(in1 + j * in1_size, in2 + j * in2_size, out + j * out_size);
+#ifdef MAP2_CHAIN_FUNC
+            if(flags & MAP2_CHAIN){
+                map_chain_func(out + j * out_size);
+            }
+#endif
+#ifdef MAP2_REDUCE_FUNC
+            if(flags & MAP2_REDUCE){
+                reduce_func(acc, out + j * out_size);
+            }
+#endif
+        }
+
+        if(flags & MAP2_WRITE_OUTPUT){
+            mram_write(out, (__mram_ptr void*)(DPU_MRAM_HEAP_POINTER + args->output_start_offset + block * out_size), ALIGN8(l_elems * out_size));
+        }
+    }
+
+#ifdef MAP2_REDUCE_FUNC
+    // tasklet 0 folds the tasklet values into the one the host gathers
+    if(flags & MAP2_REDUCE){
+        barrier_wait(&map2_barrier);
+        if(tasklet_id == 0){
+            for(uint32_t t = 1; t < NR_TASKLETS; t++){
+                reduce_combine_func(acc, reduce_acc[t]);
+            }
+            mram_write(acc, (__mram_ptr void*)(DPU_MRAM_HEAP_POINTER + args->reduce_start_offset), ALIGN8(args->reduce_type_size));
+        }
+    }
+#endif
+
+    return 0;
+}
@@ -4,7 +4,8 @@
 
 typedef uint32_t T; 
 
-const uint32_t dpu_number = 32; //2432
+// defaults, overridden at run time by the host flags / SIMPLEPIM_* variables
+uint32_t dpu_number = 32; //2432
 uint32_t print_info = 0;
-uint64_t nr_elements = 1000*dpu_number; //1000000*dpu_number
+uint64_t nr_elements = 0; // 0: 1000 elements per DPU, 1000000*dpu_number
 #endif
@@ -11,6 +11,7 @@
 #include "processing/ProcessingHelperHost.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
 
 
 
@@ -34,6 +35,17 @@ static T reduction_host(T* A) {
     return count;
 }
 
+static void input_params(int argc, char** argv){
+    host_param_t params[] = {
+        {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+        {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &nr_elements, "number of elements (0: 1000 per DPU)"},
+        {'v', "SIMPLEPIM_PRINT_INFO", PARAM_U32, &print_info, "print extra info and the DPU logs"},
+    };
+    parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+    if(nr_elements == 0)
+        nr_elements = (uint64_t)dpu_number*1000;
+}
+
 void run(){
     simplepim_management_t* table_management = table_management_init(dpu_number);
     T* A = (T*)malloc_scatter_aligned(nr_elements, sizeof(T), table_management);
@@ -72,6 +84,7 @@ void run(){
 
 
 int main(int argc, char *argv[]){
+  input_params(argc, argv);
   run();
   return 0;
 }
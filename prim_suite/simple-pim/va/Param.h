@@ -3,7 +3,9 @@
 #include <stdlib.h>
 
 typedef uint32_t T; 
-const uint32_t dpu_number = 5; //2432
+// defaults, overridden at run time by the host flags / SIMPLEPIM_* variables
+uint32_t dpu_number = 5; //2432
 uint32_t print_info = 0;
-uint64_t nr_elements = dpu_number*10000; //dpu_number*1000000
+uint32_t lazy_pipeline = 0; // fused map -> map -> reduce instead of map + gather
+uint64_t nr_elements = 0; // 0: 10000 elements per DPU, dpu_number*1000000
 #endif
\ No newline at end of file
@@ -6,13 +6,18 @@
 #include <dpu.h>
 #include <omp.h>
 
-#include "processing/map/Map.h"
-#include "processing/zip/Zip.h"
+#include "Map2.h"
 #include "processing/ProcessingHelperHost.h"
 #include "communication/CommOps.h"
 #include "management/Management.h"
 #include "timer.h"
 #include "Param.h"
+#include "HostParams.h"
+
+// DPU program of the binary map, built by the Makefile
+#ifndef MAP2_BINARY
+#define MAP2_BINARY "./bin/map2_dpu"
+#endif
 
 
 
@@ -22,19 +27,6 @@ void init(T* A, uint32_t salt){
     }
 }
 
-void zip(T* A, T* B, T* res){
-    for (uint64_t  i = 0; i < nr_elements; i++){
-        res[2*i] = A[i];
-        res[2*i+1] = B[i];
-    }
-}
-
-void vec_add(T* A, T* res){
-    for (uint64_t i = 0; i < nr_elements; i++){
-        res[i] = A[i*2] + A[i*2+1];
-    }
-}
-
 void vector_addition_host(T* A, T* B, T* res) {
     omp_set_num_threads(16);
     #pragma omp parallel for
@@ -44,6 +36,55 @@ void vector_addition_host(T* A, T* B, T* res) {
 }
 
 
+void add_int64(void* p1, void* p2){
+    *(int64_t*)p1 += *(int64_t*)p2;
+}
+
+// Lazy pipeline: sum((A + B)^2) as map -> map -> reduce in one launch, the
+// map results stay on the DPUs and only one value per DPU is gathered
+void run_lazy_pipeline(simplepim_management_t* table_management, T* A, T* B, Timer* timer){
+    int64_t correct_sum = 0;
+    for (uint64_t i = 0; i < nr_elements; i++) {
+        T v = A[i] + B[i];
+        correct_sum += v * v;
+    }
+
+    int64_t sum = 0;
+    start(timer, 1, 0);
+    table_map2_fused("t1", "t2", NULL, sizeof(T), MAP2_CHAIN | MAP2_REDUCE, sizeof(int64_t), &sum, add_int64,
+        MAP2_BINARY, table_management, 0);
+    stop(timer, 1);
+    stop(timer, 5);
+
+    printf("the total time with timing consumed is (ms): ");
+    print(timer, 5, 1);
+    printf("\n");
+    printf("initial CPU-DPU input transfer (ms): ");
+	print(timer, 0, 1);
+    printf("\n");
+	printf("DPU Kernel+DPU-CPU Time (ms): ");
+	print(timer, 1, 1);
+    printf("\n");
+
+    if(sum == correct_sum){
+        printf("the result is correct \n");
+    } else {
+        printf("result mismatch, got %lld, expected %lld \n", (long long)sum, (long long)correct_sum);
+    }
+}
+
+static void input_params(int argc, char** argv){
+    host_param_t params[] = {
+        {'d', "SIMPLEPIM_DPUS", PARAM_U32, &dpu_number, "number of DPUs"},
+        {'n', "SIMPLEPIM_ELEMENTS", PARAM_U64, &nr_elements, "number of elements (0: 10000 per DPU)"},
+        {'v', "SIMPLEPIM_PRINT_INFO", PARAM_U32, &print_info, "print extra info and the DPU logs"},
+        {'p', "SIMPLEPIM_LAZY", PARAM_U32, &lazy_pipeline, "run the fused map -> map -> reduce pipeline"},
+    };
+    parse_host_params(argc, argv, params, sizeof(params)/sizeof(params[0]));
+    if(nr_elements == 0)
+        nr_elements = (uint64_t)dpu_number*10000;
+}
+
 void run(){
     simplepim_management_t* table_management = table_management_init(dpu_number);
     T* A = (T*)malloc_scatter_aligned(nr_elements, sizeof(T), table_management);
@@ -62,13 +103,14 @@ void run(){
     stop(&timer, 0);
     printf("end of data transfer\n");
 
-    handle_t* add_handle = create_handle("va_funcs", MAP);
-    handle_t* zip_handle = create_handle("", ZIP);
-
+    if(lazy_pipeline){
+        run_lazy_pipeline(table_management, A, B, &timer);
+        return;
+    }
 
+    // t1 and t2 are streamed side by side, no zipped copy of them is made
     start(&timer, 1, 0);
-    table_zip("t1", "t2", "t3",  zip_handle, table_management);
-    table_map("t3", "t4", sizeof(T), add_handle, table_management, 0);
+    table_map2("t1", "t2", "t3", sizeof(T), MAP2_BINARY, table_management, 0);
     stop(&timer, 1);
 
     
@@ -82,7 +124,7 @@ void run(){
     
 
     start(&timer, 2, 0);
-    T* res = simplepim_gather("t4", table_management);
+    T* res = simplepim_gather("t3", table_management);
     stop(&timer, 2);
     
     printf("the total time with timing consumed is (ms): ");
@@ -118,6 +160,7 @@ void run(){
 }
 
 int main(int argc, char *argv[]){
+  input_params(argc, argv);
   run();
   return 0;
 }
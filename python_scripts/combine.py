@@ -16,6 +16,9 @@ output_file = args.output_csv
 output_csv = f"{input_dir}/{output_file}"
 
 pattern = r'(?P<elapsed>\d+:\d+\.\d+)elapsed'
+# per phase times printed in the PrIM format, e.g. "DPU Kernel Time (ms): 1.2"
+pattern_phase = r'(?<![\w+-])(?P<phase>CPU-DPU|DPU Kernel|DPU-CPU\+merge|DPU-CPU|Merge|CPU) Time \(ms\): (?P<ms>[\d.]+)'
+phases = ["CPU", "CPU-DPU", "DPU Kernel", "DPU-CPU", "DPU-CPU+merge", "Merge"]
 pattern_file = r'(?P<benchmark>[a-zA-Z0-9_]+)_dpu(?P<num_dpus>\d+)elem(?P<num_elems>\d+)trial(?P<num_trial>\d+)\.out'
 results = []
 
@@ -33,12 +36,14 @@ for filename in os.listdir(input_dir):
                     wall_time = match.group(1)
                     minutes, seconds = map(float, wall_time.split(':'))
                     total_seconds = (minutes * 60) + seconds
-                    results.append([filename, datafile["benchmark"], datafile["num_trial"], datafile["num_dpus"], datafile["num_elems"], wall_time, total_seconds])
+                    # the last report of a phase wins, missing phases stay empty
+                    phase_ms = {m.group('phase'): m.group('ms') for m in re.finditer(pattern_phase, content)}
+                    results.append([filename, datafile["benchmark"], datafile["num_trial"], datafile["num_dpus"], datafile["num_elems"], wall_time, total_seconds] + [phase_ms.get(phase, "") for phase in phases])
 
             # Write the data to a CSV file
             with open(output_csv, 'w', newline='') as csvfile:
                 csv_writer = csv.writer(csvfile)
-                csv_writer.writerow(["Filename", "Benchmark", "Trial Number", "Number of DPUs", "Number of Elements", "Wall Time [hour:min:sec]", "Walltime [sec]"])
+                csv_writer.writerow(["Filename", "Benchmark", "Trial Number", "Number of DPUs", "Number of Elements", "Wall Time [hour:min:sec]", "Walltime [sec]"] + [f"{phase} [ms]" for phase in phases])
                 csv_writer.writerows(results)
 print(f"CSV file '{output_csv}' created with wall time data.")
 
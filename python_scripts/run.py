@@ -17,6 +17,7 @@ def run_command(command, cwd=None):
             stderr=subprocess.PIPE,
         )
         print(result.stdout)
+        return result.stdout
     except subprocess.CalledProcessError as e:
         print(f"Command '{command}' failed with error:\n{e.stderr}")
         sys.exit(1)
@@ -59,7 +60,12 @@ def main():
     print(f"Running benchmark in: {benchmark_path}")
     benchmark_command = f"/usr/bin/time -o {args.time_output} {args.run_cmd} {args.args}"
     print(f"Benchmark command: {benchmark_command}")
-    run_command(benchmark_command, cwd=benchmark_path)
+    output = run_command(benchmark_command, cwd=benchmark_path)
+
+    # Step 3: Keep the benchmark output next to its timing so combine.py
+    # can pick up the per phase times the benchmark prints
+    with open(os.path.join(benchmark_path, args.time_output), "a") as file:
+        file.write(output)
 
 if __name__ == "__main__":
     main()
@@ -7,24 +7,6 @@ verbose=false  # or false
 [ -f error.out ] && rm error.out
 [ -f test.out ] && rm test.out
 
-generate_param_file_simple_pim() {
-    local dpus=$1
-    local num_elems=$2
-    local param_file="./daxby/simple-pim/Param.h"
-
-    cat > "$param_file" <<EOF
-#ifndef PARAM_H
-#define PARAM_H
-#include <stdint.h>
-#include <stdlib.h>
-typedef int32_t T; 
-const uint32_t dpu_number = ${dpus};
-uint32_t print_info = 0;
-uint64_t nr_elements = ${num_elems};
-#endif
-EOF
-}
-
 i=1
 fixed_exp=22  # Keep problem size constant
 num_elems=$((2**fixed_exp))
@@ -34,8 +16,6 @@ total=$(( ${#dpus_list[@]} * trials ))
 
 for dpus in "${dpus_list[@]}"; do
   subregions=$dpus
-  generate_param_file_simple_pim "$dpus" "$num_elems" 
-
   for trial in $(seq 1 $trials); do
     echo "DPUs: ${dpus} | Elements: ${num_elems} | Trial: ${trial}"
     
@@ -48,8 +28,9 @@ for dpus in "${dpus_list[@]}"; do
 
     CMD_SIMPLEPIM=(
         python3 "$scripts/run.py" daxby simple-pim
+        --args "-d ${dpus} -n ${num_elems}"
         --run_cmd "./bin/host"
-        --build_cmd "make clean && make -j"
+        --build_cmd "make -j"
         --time_output "daxby_dpu${dpus}elem${num_elems}trial${trial}.out"
     )
 
@@ -0,0 +1,47 @@
+#!/bin/bash
+# SOA (-s 0) vs AOS (-s 1) daxpy throughput of the legion-pim port
+scripts=python_scripts
+stderr=error.out
+stdout=test.out
+verbose=false  # or true
+
+[ -f error.out ] && rm error.out
+[ -f test.out ] && rm test.out
+
+dpus_list=(4 8 16 32 64)
+exps=(18 20 22)
+layouts=(soa aos)
+iters=10
+trials=5
+
+for dpus in "${dpus_list[@]}"; do
+  subregions=$dpus
+  for exp in "${exps[@]}"; do
+    num_elems=$((2**exp))
+    for s in 0 1; do
+      layout=${layouts[$s]}
+      for trial in $(seq 1 $trials); do
+        echo "DPUs: ${dpus} | Elements: ${num_elems} | Layout: ${layout} | Trial: ${trial}"
+
+        CMD_LEGION=(
+            python3 "$scripts/run.py" daxby legion-pim
+            --args "-ll:num_dpus ${dpus} -b ${subregions} -n ${num_elems} -s ${s} -iters ${iters}"
+            --build_cmd "make -j"
+            --time_output "daxby_${layout}_dpu${dpus}elem${num_elems}trial${trial}.out"
+        )
+
+        if [ "$verbose" = true ]; then
+          "${CMD_LEGION[@]}" 2>>"$stderr" | tee -a "$stdout"
+        else
+          "${CMD_LEGION[@]}" >>"$stdout" 2>>"$stderr"
+        fi
+      done
+    done
+  done
+done
+
+echo "Throughput per layout"
+grep "throughput" "$stdout"
+
+echo "STDERR output below"
+cat error.out
@@ -42,22 +42,10 @@ for dpus in 4 8 16 32 64; do
   for exp in {15..22}; do
     num_elems=$((2**exp))
     
-cat > ./daxby/simple-pim/Param.h <<EOF
-    #ifndef PARAM_H
-    #define PARAM_H
-    #include <stdint.h>
-    #include <stdlib.h>
-    typedef int32_t T; 
-    const uint32_t dpu_number = ${dpus};
-    uint32_t print_info = 0;
-    uint64_t nr_elements = ${num_elems};
-    #endif
-EOF
-
   for trial in {1..10}; do  
     show_progress $i $((5 * 8 * 10))
     python3 $scripts/run.py daxby legion-pim --args "-ll:num_dpus ${dpus} -b ${subregions} -n ${num_elems}" --build_cmd "make -j" --time_output "daxby_dpu${dpus}elem${num_elems}trial${trial}.out" >> $stdout 2>> $stderr
-    python3 $scripts/run.py daxby simple-pim  --run_cmd "./bin/host" --build_cmd "make clean && make -j" --time_output "daxby_dpu${dpus}elem${num_elems}trial${trial}.out" >> $stdout 2>> $stderr
+    python3 $scripts/run.py daxby simple-pim  --args "-d ${dpus} -n ${num_elems}" --run_cmd "./bin/host" --build_cmd "make -j" --time_output "daxby_dpu${dpus}elem${num_elems}trial${trial}.out" >> $stdout 2>> $stderr
     i=$((i + 1))  
 done
 done
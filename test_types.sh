@@ -0,0 +1,47 @@
+#!/bin/bash
+# daxpy throughput of the legion-pim port per element type, one build each
+scripts=python_scripts
+stderr=error.out
+stdout=test.out
+verbose=false  # or true
+
+[ -f error.out ] && rm error.out
+[ -f test.out ] && rm test.out
+
+types=(INT8 INT16 INT32 INT64 FIXED FLOAT DOUBLE)
+dpus_list=(16 64)
+fixed_exp=22
+num_elems=$((2**fixed_exp))
+iters=10
+trials=5
+
+for type in "${types[@]}"; do
+  # the first run of every type rebuilds host and DPU binary for that type
+  build_cmd="make clean && make -j TYPE=${type}"
+  for dpus in "${dpus_list[@]}"; do
+    subregions=$dpus
+    for trial in $(seq 1 $trials); do
+      echo "Type: ${type} | DPUs: ${dpus} | Elements: ${num_elems} | Trial: ${trial}"
+
+      CMD_LEGION=(
+          python3 "$scripts/run.py" daxby legion-pim
+          --args "-ll:num_dpus ${dpus} -b ${subregions} -n ${num_elems} -iters ${iters}"
+          --build_cmd "${build_cmd}"
+          --time_output "daxby_${type,,}_dpu${dpus}elem${num_elems}trial${trial}.out"
+      )
+
+      if [ "$verbose" = true ]; then
+        "${CMD_LEGION[@]}" 2>>"$stderr" | tee -a "$stdout"
+      else
+        "${CMD_LEGION[@]}" >>"$stdout" 2>>"$stderr"
+      fi
+      build_cmd="make -j TYPE=${type}"
+    done
+  done
+done
+
+echo "Throughput per type"
+grep "throughput" "$stdout"
+
+echo "STDERR output below"
+cat error.out